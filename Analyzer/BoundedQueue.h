@@ -0,0 +1,71 @@
+//
+//  BoundedQueue.h
+//  Analyzer
+//
+//  Created by kTeam on 10/19/26.
+//  Copyright © 2026 kTeam. All rights reserved.
+//
+
+#ifndef MM_BOUNDEDQUEUE_H
+#define MM_BOUNDEDQUEUE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+
+/**
+ * Blocking multi-producer, multi-consumer queue with a fixed capacity.
+ */
+template <typename T>
+class BoundedQueue {
+public:
+	BoundedQueue(size_t capacity)
+	: mCapacity(capacity), mClosed(false) { }
+	
+	/**
+	 * Add an item, waiting while the queue is full.
+	 */
+	void push(T item) {
+		std::unique_lock<std::mutex> lock(mMutex);
+		mNotFull.wait(lock, [this] { return mItems.size() < mCapacity; });
+		mItems.push_back(std::move(item));
+		mNotEmpty.notify_one();
+	}
+	
+	/**
+	 * Remove an item, waiting while the queue is empty.
+	 * @return False once the queue has been closed and drained
+	 */
+	bool pop(T& item) {
+		std::unique_lock<std::mutex> lock(mMutex);
+		mNotEmpty.wait(lock, [this] { return !mItems.empty() || mClosed; });
+		if(mItems.empty()) {
+			return false;
+		}
+		
+		item = std::move(mItems.front());
+		mItems.pop_front();
+		mNotFull.notify_one();
+		return true;
+	}
+	
+	/**
+	 * Signal that no more items will be pushed.
+	 */
+	void close() {
+		std::lock_guard<std::mutex> lock(mMutex);
+		mClosed = true;
+		mNotEmpty.notify_all();
+	}
+	
+private:
+	std::mutex mMutex;
+	std::condition_variable mNotEmpty, mNotFull;
+	std::deque<T> mItems;
+	size_t mCapacity;
+	bool mClosed;
+};
+
+#endif /* MM_BOUNDEDQUEUE_H */
@@ -0,0 +1,319 @@
+//
+//  main.cpp
+//  Analyzer
+//
+//  Created by kTeam on 10/19/26.
+//  Copyright © 2026 kTeam. All rights reserved.
+//
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Board.h"
+#include "BoardTree.h"
+#include "GameLog.h"
+#include "NTupleEvaluator.h"
+#include "ScoreCache.h"
+#include "ShiftNode.h"
+#include "BoundedQueue.h"
+
+
+/*
+ * Bulk position analysis. Positions are read straight out of a memory-mapped input file,
+ * either a raw array of CompressedGrid values or a game log. The pipeline is:
+ *
+ *   reader -> bounded queue of batches -> worker pool (one BoardTree each) -> ordered writer
+ *
+ * The writer emits one line per position in input order: the grid in hex, the best direction
+ * (U/D/L/R, or - when the game is already over) and the score of the search.
+ */
+
+static const size_t kBatchSize = 256;
+
+struct Result {
+	CompressedGrid grid;
+	char dir;
+	int score;
+};
+
+struct Batch {
+	size_t seq;
+	size_t first;
+	size_t count;
+	std::vector<Result> results;
+};
+
+
+/**
+ * Positions inside a mapped file. Raw grid files have a stride of 8 bytes, game logs have
+ * the grid at the start of each record.
+ */
+struct PositionSource {
+	const char* base;
+	size_t stride;
+	size_t count;
+	
+	CompressedGrid operator[](size_t index) const {
+		CompressedGrid grid;
+		memcpy(&grid, base + index * stride, sizeof(grid));
+		return grid;
+	}
+};
+
+
+/**
+ * Collects finished batches and writes them out in sequence order. The reader waits on the
+ * writer before dispatching, so at most @p window batches are ever in flight.
+ */
+class OrderedWriter {
+public:
+	OrderedWriter(FILE* out, size_t window)
+	: mOut(out), mWindow(window), mNextSeq(0) { }
+	
+	void waitForSlot(size_t seq) {
+		std::unique_lock<std::mutex> lock(mMutex);
+		mWritten.wait(lock, [&] { return seq < mNextSeq + mWindow; });
+	}
+	
+	void submit(Batch batch) {
+		std::lock_guard<std::mutex> lock(mMutex);
+		size_t seq = batch.seq;
+		mPending.emplace(seq, std::move(batch));
+		mReady.notify_one();
+	}
+	
+	void run(size_t batchCount) {
+		while(true) {
+			Batch batch;
+			{
+				std::unique_lock<std::mutex> lock(mMutex);
+				if(mNextSeq == batchCount) {
+					break;
+				}
+				
+				mReady.wait(lock, [&] { return mPending.count(mNextSeq) != 0; });
+				auto it = mPending.find(mNextSeq);
+				batch = std::move(it->second);
+				mPending.erase(it);
+			}
+			
+			// Write outside the lock so workers can keep submitting
+			for(const Result& result : batch.results) {
+				fprintf(mOut, "%016llx %c %d\n", (unsigned long long)result.grid, result.dir, result.score);
+			}
+			
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				++mNextSeq;
+				mWritten.notify_all();
+			}
+		}
+	}
+
+private:
+	std::mutex mMutex;
+	std::condition_variable mReady, mWritten;
+	std::map<size_t, Batch> mPending;
+	FILE* mOut;
+	size_t mWindow;
+	size_t mNextSeq;
+};
+
+
+static void analyzeBatch(BoardTree& tree, const PositionSource& positions, Batch& batch) {
+	static const char kDirChars[4] = {'U', 'D', 'L', 'R'};
+	
+	batch.results.resize(batch.count);
+	for(size_t i = 0; i < batch.count; i++) {
+		Result& result = batch.results[i];
+		result.grid = positions[batch.first + i];
+		
+		Board board(result.grid);
+		if(board.isGameOver()) {
+			result.dir = '-';
+			result.score = 0;
+			continue;
+		}
+		
+		tree.setBoard(board);
+		result.dir = kDirChars[(int)tree.getBestMove()];
+		result.score = tree.getLastScore();
+	}
+}
+
+
+static void usage(const char* argv0) {
+	fprintf(stderr,
+		"Usage: %s [-l] [-j threads] [-c cache] [-w weights] input output\n"
+		"  -l          Input is a game log instead of raw CompressedGrid values\n"
+		"  -j threads  Number of worker threads (default: one per core)\n"
+		"  -c cache    Persistent score cache shared by all workers\n"
+		"  -w weights  Evaluate leaves with an n-tuple network loaded from this file\n",
+		argv0
+	);
+	exit(EXIT_FAILURE);
+}
+
+
+int main(int argc, char** argv) {
+	bool gameLogInput = false;
+	unsigned threadCount = std::thread::hardware_concurrency();
+	const char* cachePath = nullptr;
+	const char* weightsPath = nullptr;
+	
+	int opt;
+	while((opt = getopt(argc, argv, "lj:c:w:")) != -1) {
+		switch(opt) {
+			case 'l':
+				gameLogInput = true;
+				break;
+			
+			case 'j':
+				threadCount = (unsigned)atoi(optarg);
+				break;
+			
+			case 'c':
+				cachePath = optarg;
+				break;
+			
+			case 'w':
+				weightsPath = optarg;
+				break;
+			
+			default:
+				usage(argv[0]);
+		}
+	}
+	if(argc - optind != 2) {
+		usage(argv[0]);
+	}
+	if(threadCount == 0) {
+		threadCount = 1;
+	}
+	const char* inputPath = argv[optind];
+	const char* outputPath = argv[optind + 1];
+	
+	// Prepare the lookup tables
+	Board::fillShiftTable();
+	Board::fillScoreTable();
+	
+	std::unique_ptr<NTupleEvaluator> evaluator;
+	if(weightsPath) {
+		evaluator = NTupleEvaluator::load(weightsPath);
+		if(!evaluator) {
+			return EXIT_FAILURE;
+		}
+		Board::setEvaluator(evaluator.get());
+	}
+	
+	std::unique_ptr<ScoreCache> cache;
+	if(cachePath) {
+		cache = ScoreCache::open(cachePath, 1 << 24, Board::heuristicVersion());
+		ShiftNode::setScoreCache(cache.get());
+	}
+	
+	// Map the input file
+	PositionSource positions;
+	std::unique_ptr<GameLogReader> gameLog;
+	void* map = MAP_FAILED;
+	size_t mapSize = 0;
+	if(gameLogInput) {
+		gameLog = GameLogReader::open(inputPath);
+		if(!gameLog) {
+			return EXIT_FAILURE;
+		}
+		positions = {(const char*)gameLog->begin(), sizeof(GameLogRecord), gameLog->size()};
+	}
+	else {
+		int fd = open(inputPath, O_RDONLY);
+		struct stat st;
+		if(fd < 0 || fstat(fd, &st) != 0) {
+			fprintf(stderr, "Failed to open %s: %s\n", inputPath, strerror(errno));
+			return EXIT_FAILURE;
+		}
+		
+		mapSize = st.st_size;
+		if(mapSize > 0) {
+			map = mmap(nullptr, mapSize, PROT_READ, MAP_SHARED, fd, 0);
+			if(map == MAP_FAILED) {
+				fprintf(stderr, "Failed to map %s: %s\n", inputPath, strerror(errno));
+				return EXIT_FAILURE;
+			}
+			madvise(map, mapSize, MADV_SEQUENTIAL);
+		}
+		close(fd);
+		positions = {(const char*)map, sizeof(CompressedGrid), mapSize / sizeof(CompressedGrid)};
+	}
+	
+	FILE* out = fopen(outputPath, "w");
+	if(!out) {
+		fprintf(stderr, "Failed to create %s: %s\n", outputPath, strerror(errno));
+		return EXIT_FAILURE;
+	}
+	
+	auto startTime = std::chrono::steady_clock::now();
+	size_t batchCount = (positions.count + kBatchSize - 1) / kBatchSize;
+	BoundedQueue<Batch> queue(threadCount * 2);
+	OrderedWriter writer(out, threadCount * 4);
+	
+	// Workers each own a BoardTree, whose nodes come from that thread's pools
+	std::vector<std::thread> workers;
+	for(unsigned i = 0; i < threadCount; i++) {
+		workers.emplace_back([&] {
+			BoardTree tree{Board()};
+			tree.setLogging(false);
+			
+			Batch batch;
+			while(queue.pop(batch)) {
+				analyzeBatch(tree, positions, batch);
+				writer.submit(std::move(batch));
+			}
+		});
+	}
+	
+	// Reader hands out batches in order, never getting too far ahead of the writer
+	std::thread reader([&] {
+		for(size_t seq = 0; seq < batchCount; seq++) {
+			writer.waitForSlot(seq);
+			
+			Batch batch;
+			batch.seq = seq;
+			batch.first = seq * kBatchSize;
+			batch.count = std::min(kBatchSize, positions.count - batch.first);
+			queue.push(std::move(batch));
+		}
+		queue.close();
+	});
+	
+	writer.run(batchCount);
+	reader.join();
+	for(std::thread& worker : workers) {
+		worker.join();
+	}
+	
+	fclose(out);
+	if(map != MAP_FAILED) {
+		munmap(map, mapSize);
+	}
+	
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	fprintf(stderr, "Analyzed %zu positions in %.2fs (%.0f positions/sec) on %u threads\n",
+		positions.count, seconds, positions.count / seconds, threadCount
+	);
+	return 0;
+}
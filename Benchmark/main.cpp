@@ -0,0 +1,546 @@
+//
+//  main.cpp
+//  Benchmark
+//
+//  Created by kTeam on 10/19/26.
+//  Copyright © 2026 kTeam. All rights reserved.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+
+#include "BasicBoard.h"
+#include "Board.h"
+#include "BoardTree.h"
+#include "DepthFirstSearch.h"
+#include "FrontierSearch.h"
+#include "HugePages.h"
+#include "PerfCounters.h"
+
+
+/*
+ * Micro-benchmarks for the board kernels and the search. Positions are sampled from random
+ * games with a fixed seed, so runs are comparable across machines and kernel variants. Every
+ * variant the CPU supports is timed on the same positions, and a checksum of the results
+ * catches variants that disagree. The search is timed with the node tree, the depth-first
+ * and the frontier engines at the same depth, and the tree again on 5x5 boards. Where the
+ * kernel exposes hardware counters, IPC and cache, branch and dTLB misses are reported alongside
+ * the times, per node for the searches, so runs with and without huge pages (-H) can be compared.
+ * Where it only exposes software events, CPU time is reported instead. Searches also report
+ * their median, 99th percentile and longest time, and with -l the tree search breaks them down
+ * by empty cells and largest tile.
+ */
+
+static const char* const kKernelNames[] = {"scalar", "sse4", "bmi2", "avx2"};
+
+typedef std::chrono::steady_clock Clock;
+
+
+// Opened by main(), whose thread runs everything but the node pool benchmark
+static std::unique_ptr<PerfCounters> sCounters;
+
+// Set by -l
+static bool sPrintLatencies = false;
+
+
+static PerfCounters::Sample readingCounters() {
+	return sCounters ? sCounters->read() : PerfCounters::Sample();
+}
+
+
+/**
+ * Print the median, 99th percentile and longest of the searches @p tree timed.
+ */
+template<class BoardType>
+static void printingLatencies(const BasicBoardTree<BoardType>& tree) {
+	LatencyHistogram total = tree.getLatencies().getTotal();
+	printf("  p50/p99/max %.1f/%.1f/%.1f us", total.getPercentile(50) / 1e3, total.getPercentile(99) / 1e3, total.getMax() / 1e3);
+}
+
+
+/**
+ * Print @p counts per one of @p count units, if anything was counted.
+ */
+static void printingCounts(const PerfCounters::Sample& counts, double count, const char* unit) {
+	char text[256];
+	if(PerfCounters::format(text, sizeof(text), counts, count, unit)) {
+		printf("  %s", text);
+	}
+}
+
+
+template<class BoardType>
+static std::vector<BoardType> samplePositions(size_t count, uint32_t seed) {
+	std::mt19937 rng(seed);
+	std::vector<BoardType> positions;
+	positions.reserve(count);
+	
+	BoardType board;
+	while(positions.size() < count) {
+		if(board.isEmpty() || board.isGameOver()) {
+			board = BoardType();
+			board.placeRandom(rng);
+			board.placeRandom(rng);
+		}
+		positions.push_back(board);
+		
+		// Random moves keep the sample cheap while still reaching crowded boards
+		while(!board.shiftTiles((Direction)(rng() % 4)) && !board.isGameOver()) { }
+		if(!board.isGameOver()) {
+			board.placeRandom(rng);
+		}
+	}
+	return positions;
+}
+
+
+/**
+ * Time @p op over every position and report nanoseconds per position.
+ */
+template<typename Op>
+static uint64_t timing(const char* label, const std::vector<Board>& positions, unsigned repeat, Op op) {
+	uint64_t checksum = 0;
+	PerfCounters::Sample counts = readingCounters();
+	Clock::time_point start = Clock::now();
+	for(unsigned r = 0; r < repeat; r++) {
+		for(const Board& board : positions) {
+			checksum = checksum * 31 + op(board);
+		}
+	}
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	printf("  %-12s %8.2f ns/op", label, seconds * 1e9 / ((double)positions.size() * repeat));
+	printingCounts(readingCounters() - counts, (double)positions.size() * repeat, "op");
+	printf("\n");
+	return checksum;
+}
+
+
+static uint64_t benchmarkKernels(const std::vector<Board>& positions, unsigned repeat) {
+	uint64_t checksum = 0;
+	
+	checksum ^= timing("allShifts", positions, repeat, [](Board board) {
+		Board shifts[4];
+		board.allShifts(shifts);
+		return shifts[0].getCompressedGrid() ^ shifts[1].getCompressedGrid() ^
+			shifts[2].getCompressedGrid() ^ shifts[3].getCompressedGrid();
+	});
+	
+	checksum ^= timing("shiftTiles", positions, repeat, [](Board board) {
+		board.shiftTiles(Direction::UP);
+		return board.getCompressedGrid();
+	});
+	
+	checksum ^= timing("isGameOver", positions, repeat, [](Board board) {
+		return (uint64_t)board.isGameOver();
+	});
+	
+	checksum ^= timing("findHoles", positions, repeat, [](Board board) {
+		int holes[16];
+		unsigned count = board.findHoles(holes);
+		return (uint64_t)count + (count ? holes[count - 1] : 0);
+	});
+	
+	checksum ^= timing("allPlaces", positions, repeat, [](Board board) {
+		Board places[32];
+		unsigned count = board.allPlaces(places);
+		return (uint64_t)count + (count ? places[2 * count - 1].getCompressedGrid() : 0);
+	});
+	
+	checksum ^= timing("estimateScore", positions, repeat, [](Board board) {
+		return (uint64_t)(int64_t)board.estimateScore();
+	});
+	
+	return checksum;
+}
+
+
+static uint64_t benchmarkSearch(const char* label, SearchEngine engine, SearchDriver driver, const std::vector<Board>& positions, size_t count, unsigned depth, uint64_t budget, size_t memory) {
+	BoardTree tree{Board()};
+	tree.setLogging(false);
+	tree.setMemoryBudget(memory);
+	tree.setMaximumDepth(depth);
+	tree.setSearchEngine(engine);
+	tree.setSearchDriver(driver);
+	tree.setNodeBudget(budget);
+	tree.setCounting(sCounters != nullptr);
+	
+	uint64_t checksum = 0, nodes = 0, depths = 0, live = 0;
+	size_t searched = 0;
+	PerfCounters::Sample counts;
+	Clock::time_point start = Clock::now();
+	for(size_t i = 0; i < positions.size() && searched < count; i++) {
+		if(positions[i].isGameOver()) {
+			continue;
+		}
+		tree.setBoard(positions[i]);
+		checksum = checksum * 31 + (uint64_t)tree.getBestMove();
+		checksum = checksum * 31 + (uint64_t)(int64_t)tree.getLastScore();
+		nodes += tree.getNodeCount();
+		depths += tree.getLastDepth();
+		live += ShiftNode::getLiveCount() + PlaceNode::getLiveCount();
+		counts += tree.getLastCounts();
+		++searched;
+	}
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	if(budget) {
+		printf("  %-12s %8.1f us/search (budget %llu, mean depth %.2f, %.0f nodes/search)", label,
+			seconds * 1e6 / searched, (unsigned long long)budget, (double)depths / searched, (double)nodes / searched);
+	}
+	else {
+		printf("  %-12s %8.1f us/search (depth %u, %zu positions, %.0f nodes/search)", label,
+			seconds * 1e6 / searched, depth, searched, (double)nodes / searched);
+	}
+	printingCounts(counts, (double)nodes, "node");
+	
+	printingLatencies(tree);
+	
+	// Only the tree engine keeps nodes, each board once however many paths reach it
+	if(engine == SearchEngine::TREE) {
+		printf(" %.0f tree nodes, %zu KiB high water", (double)live / searched, BoardTree::getHighWaterBytes() / 1024);
+	}
+	printf("\n");
+	if(sPrintLatencies && engine == SearchEngine::TREE && driver == SearchDriver::ALPHA_BETA) {
+		tree.getLatencies().print(stdout);
+	}
+	return checksum;
+}
+
+
+/**
+ * Time the tree search on 5x5 boards. Their line tables are megabytes and their place nodes
+ * have up to 50 children, so this is where the search waits on memory the most.
+ */
+static void benchmarkLargeSearch(size_t count, unsigned depth) {
+	typedef BasicBoard<5, 4> LargeBoard;
+	LargeBoard::fillShiftTable();
+	LargeBoard::fillScoreTable();
+	std::vector<LargeBoard> positions = samplePositions<LargeBoard>(count, 2048);
+	
+	BasicBoardTree<LargeBoard> tree{LargeBoard()};
+	tree.setLogging(false);
+	tree.setMaximumDepth(depth);
+	tree.setCounting(sCounters != nullptr);
+	
+	uint64_t nodes = 0;
+	size_t searched = 0;
+	PerfCounters::Sample counts;
+	Clock::time_point start = Clock::now();
+	for(const LargeBoard& position : positions) {
+		if(position.isGameOver()) {
+			continue;
+		}
+		tree.setBoard(position);
+		tree.getBestMove();
+		nodes += tree.getNodeCount();
+		counts += tree.getLastCounts();
+		++searched;
+	}
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	printf("  %-12s %8.1f us/search (depth %u, %zu positions, %.0f nodes/search)", "treeSearch",
+		seconds * 1e6 / searched, depth, searched, (double)nodes / searched);
+	printingCounts(counts, (double)nodes, "node");
+	printingLatencies(tree);
+	printf("\n");
+	if(sPrintLatencies) {
+		tree.getLatencies().print(stdout);
+	}
+}
+
+
+/**
+ * Time the frontier engine directly, without BoardTree's depth adjustments, and report its
+ * node rate.
+ */
+static uint64_t benchmarkFrontier(const char* label, SearchMode mode, const std::vector<Board>& positions, size_t count, unsigned depth) {
+	FrontierSearch search;
+	uint64_t checksum = 0, nodes = 0;
+	size_t searched = 0;
+	Clock::time_point start = Clock::now();
+	for(size_t i = 0; i < positions.size() && searched < count; i++) {
+		if(positions[i].isGameOver()) {
+			continue;
+		}
+		Direction dir = Direction::UP;
+		SearchBudget budget;
+		checksum = checksum * 31 + (uint64_t)(int64_t)search.search(positions[i], depth, mode, budget, &dir);
+		checksum = checksum * 31 + (uint64_t)dir;
+		nodes += budget.getUsed();
+		++searched;
+	}
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	printf("  %-12s %8.1f us/search (depth %u, %.1f Mnodes/s)\n", label, seconds * 1e6 / searched, depth, nodes / seconds / 1e6);
+	return checksum;
+}
+
+
+/**
+ * Time the depth-first engine's expectimax search and report how much of it Star1 and Star2
+ * pruned. Star2 only cuts under the null windows of @p nullWindows. The pruning must leave the
+ * results of the full-width frontier search unchanged, wherever the frontier search wasn't cut
+ * short by its level size limit.
+ * @return False on any disagreement
+ */
+static bool benchmarkExpectimax(const char* label, const std::vector<Board>& positions, size_t count, unsigned depth, bool nullWindows) {
+	DepthFirstSearch search;
+	search.setNullWindows(nullWindows);
+	std::vector<std::pair<int, Direction>> results;
+	uint64_t nodes = 0;
+	size_t searched = 0;
+	Clock::time_point start = Clock::now();
+	for(size_t i = 0; i < positions.size() && searched < count; i++) {
+		if(positions[i].isGameOver()) {
+			continue;
+		}
+		Direction dir = Direction::UP;
+		SearchBudget budget;
+		int score = search.search(positions[i], depth, SearchMode::EXPECTIMAX, budget, &dir);
+		results.emplace_back(score, dir);
+		nodes += budget.getUsed();
+		++searched;
+	}
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	
+	const DepthFirstSearch::PruningStats& stats = search.getPruningStats();
+	double placements = stats.placements ? (double)stats.placements : 1.0;
+	printf("  %-12s %8.1f us/search (depth %u, %.0f nodes/search, Star1 pruned %.1f%%, Star2 %.1f%% of placements)\n",
+		label, seconds * 1e6 / searched, depth, (double)nodes / searched,
+		100.0 * stats.star1Pruned / placements, 100.0 * stats.star2Pruned / placements);
+	
+	FrontierSearch frontier;
+	size_t next = 0;
+	for(size_t i = 0; i < positions.size() && next < results.size(); i++) {
+		if(positions[i].isGameOver()) {
+			continue;
+		}
+		Direction dir = Direction::UP;
+		SearchBudget budget;
+		int score = frontier.search(positions[i], depth, SearchMode::EXPECTIMAX, budget, &dir);
+		if(frontier.getLastDepth() == depth && std::make_pair(score, dir) != results[next]) {
+			return false;
+		}
+		++next;
+	}
+	return true;
+}
+
+
+/**
+ * Time node allocation with @p threadCount threads at once. Each thread repeatedly creates
+ * shift nodes for @p count positions and frees them all again. That's more than a thread's cache
+ * holds, so most of the nodes pass through the pool's shared overflow, where the threads
+ * contend with each other.
+ */
+static void benchmarkPool(const std::vector<Board>& positions, size_t count, unsigned repeat, unsigned threadCount) {
+	count = std::min(count, positions.size());
+	auto churning = [&](size_t offset) {
+		std::vector<ShiftNode*> nodes(count);
+		for(unsigned r = 0; r < repeat; r++) {
+			for(size_t i = 0; i < count; i++) {
+				nodes[i] = ShiftNode::acquire(positions[(offset + i) % positions.size()]);
+			}
+			for(ShiftNode* node : nodes) {
+				node->release();
+			}
+			BoardTree::reclaim(SIZE_MAX);
+		}
+	};
+	
+	Clock::time_point start = Clock::now();
+	std::vector<std::thread> threads;
+	for(unsigned i = 0; i < threadCount; i++) {
+		threads.emplace_back(churning, i * count);
+	}
+	for(std::thread& thread : threads) {
+		thread.join();
+	}
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	double nodes = (double)count * repeat * threadCount;
+	printf("  %u thread%s %8.2f ns/node, %6.1f Mnodes/s in all\n", threadCount, threadCount == 1 ? ": " : "s:",
+		seconds * 1e9 * threadCount / nodes, nodes / seconds / 1e6);
+}
+
+
+static void usage(const char* argv0) {
+	fprintf(stderr,
+		"Usage: %s [-n positions] [-r repeat] [-s searches] [-d depth] [-b nodes] [-m bytes] [-j threads] [-k kernels] [-H] [-l]\n"
+		"  -n positions  Number of sampled positions (default: 100000)\n"
+		"  -r repeat     Passes over the positions per kernel (default: 20)\n"
+		"  -s searches   Number of positions searched (default: 200)\n"
+		"  -d depth      Search depth (default: 3)\n"
+		"  -b nodes      Limit searches by node count instead of depth\n"
+		"  -m bytes      Limit the memory of tree nodes kept between searches\n"
+		"  -j threads    Most threads allocating nodes at once (default: one per core)\n"
+		"  -k kernels    Only run this kernel variant\n"
+		"  -H            Back the tables and tree nodes with huge pages\n"
+		"  -l            Print tree search times by empty cells and largest tile\n",
+		argv0
+	);
+	exit(EXIT_FAILURE);
+}
+
+
+int main(int argc, char** argv) {
+	size_t positionCount = 100000;
+	unsigned repeat = 20;
+	size_t searchCount = 200;
+	unsigned depth = 3;
+	uint64_t budget = 0;
+	size_t memory = 0;
+	unsigned threadCount = std::thread::hardware_concurrency();
+	const char* onlyKernels = nullptr;
+	
+	int opt;
+	while((opt = getopt(argc, argv, "n:r:s:d:b:m:j:k:Hl")) != -1) {
+		switch(opt) {
+			case 'n':
+				positionCount = strtoull(optarg, nullptr, 10);
+				break;
+			
+			case 'r':
+				repeat = (unsigned)atoi(optarg);
+				break;
+			
+			case 's':
+				searchCount = strtoull(optarg, nullptr, 10);
+				break;
+			
+			case 'd':
+				depth = (unsigned)atoi(optarg);
+				break;
+			
+			case 'b':
+				budget = strtoull(optarg, nullptr, 10);
+				break;
+			
+			case 'm':
+				memory = strtoull(optarg, nullptr, 10);
+				break;
+			
+			case 'j':
+				threadCount = (unsigned)atoi(optarg);
+				break;
+			
+			case 'k':
+				onlyKernels = optarg;
+				break;
+			
+			case 'H':
+				HugePages::setEnabled(true);
+				break;
+			
+			case 'l':
+				sPrintLatencies = true;
+				break;
+			
+			default:
+				usage(argv[0]);
+		}
+	}
+	if(optind != argc || positionCount == 0 || repeat == 0) {
+		usage(argv[0]);
+	}
+	
+	Board::fillShiftTable();
+	Board::fillScoreTable();
+	
+	const char* startupKernels = Board::kernelName();
+	printf("Startup picked %s kernels\n", startupKernels);
+	sCounters = PerfCounters::open();
+	if(!sCounters) {
+		printf("Performance counters can't be opened here\n");
+	}
+	else if(!sCounters->isCounted(PerfCounters::CYCLES)) {
+		printf("Hardware counters aren't available here, counting CPU time instead\n");
+	}
+	
+	std::vector<Board> positions = samplePositions<Board>(positionCount, 2048);
+	
+	uint64_t expected = 0;
+	bool haveExpected = false, mismatch = false;
+	for(const char* name : kKernelNames) {
+		if(onlyKernels && strcmp(name, onlyKernels) != 0) {
+			continue;
+		}
+		if(!Board::selectKernels(name)) {
+			if(onlyKernels) {
+				return EXIT_FAILURE;
+			}
+			continue;
+		}
+		
+		printf("%s%s:\n", name, strcmp(name, startupKernels) == 0 ? " (startup)" : "");
+		uint64_t checksum = benchmarkKernels(positions, repeat);
+		
+		// The engines search the same positions to the same depth and must agree on every result
+		uint64_t treeChecksum = benchmarkSearch("treeSearch", SearchEngine::TREE, SearchDriver::ALPHA_BETA, positions, searchCount, depth, budget, memory);
+		uint64_t dfsChecksum = benchmarkSearch("dfsSearch", SearchEngine::DEPTH_FIRST, SearchDriver::ALPHA_BETA, positions, searchCount, depth, budget, memory);
+		uint64_t frontierChecksum = benchmarkSearch("bfsSearch", SearchEngine::FRONTIER, SearchDriver::ALPHA_BETA, positions, searchCount, depth, budget, memory);
+		
+		// Nodes the tree shares between paths are visited more cheaply than the depth-first
+		// engine's, so under a budget the tree legitimately gets deeper
+		if(!budget && treeChecksum != dfsChecksum) {
+			printf("  MISMATCH: the depth-first search disagrees with the tree\n");
+			mismatch = true;
+		}
+		
+		// The frontier engine is charged for every board it generates rather than every board it
+		// visits, so under a budget it legitimately stops at other depths
+		if(!budget && treeChecksum != frontierChecksum) {
+			printf("  MISMATCH: the frontier search disagrees with the tree\n");
+			mismatch = true;
+		}
+		
+		// The drivers only change how many nodes it takes to reach the same answer
+		uint64_t pvsChecksum = benchmarkSearch("pvsSearch", SearchEngine::TREE, SearchDriver::PRINCIPAL_VARIATION, positions, searchCount, depth, budget, memory);
+		uint64_t mtdfChecksum = benchmarkSearch("mtdfSearch", SearchEngine::TREE, SearchDriver::MTDF, positions, searchCount, depth, budget, memory);
+		if(!budget && (treeChecksum != pvsChecksum || treeChecksum != mtdfChecksum)) {
+			printf("  MISMATCH: a search driver disagrees with plain alpha-beta\n");
+			mismatch = true;
+		}
+		checksum ^= treeChecksum;
+		
+		// Raw frontier throughput at the full depth, where the levels are big enough to batch
+		checksum ^= benchmarkFrontier("bfsMinimax", SearchMode::MINIMAX, positions, searchCount, depth);
+		benchmarkFrontier("bfsExpectimax", SearchMode::EXPECTIMAX, positions, searchCount, depth);
+		bool pruningHolds = benchmarkExpectimax("dfsExpectimax", positions, searchCount, depth, false);
+		pruningHolds &= benchmarkExpectimax("pvsExpectimax", positions, searchCount, depth, true);
+		if(!pruningHolds) {
+			printf("  MISMATCH: Star1/Star2 pruning changed expectimax results\n");
+			mismatch = true;
+		}
+		
+		if(haveExpected && checksum != expected) {
+			printf("  MISMATCH: results differ from the previous variant\n");
+			mismatch = true;
+		}
+		expected = checksum;
+		haveExpected = true;
+	}
+	
+	Board::selectKernels(startupKernels);
+	
+	printf("5x5 boards:\n");
+	benchmarkLargeSearch(searchCount, depth);
+	
+	// Node allocation is independent of the kernels, so it's timed once, doubling the threads up
+	// to the most asked for, which is always timed even if it isn't a power of two
+	printf("node pool:\n");
+	unsigned mostThreads = std::max(threadCount, 1u);
+	for(unsigned threads = 1; threads < mostThreads; threads *= 2) {
+		benchmarkPool(positions, 1 << 16, repeat, threads);
+	}
+	benchmarkPool(positions, 1 << 16, repeat, mostThreads);
+	
+	if(HugePages::isEnabled()) {
+		printf("huge pages: %zu KiB in use\n", HugePages::getHugeBytes() / 1024);
+	}
+	return mismatch ? EXIT_FAILURE : 0;
+}
@@ -0,0 +1,500 @@
+//
+//  BasicBoard.cpp
+//  CAP4053_Minimax
+//
+//  Created by kTeam on 10/19/26.
+//  Copyright © 2026 kTeam. All rights reserved.
+//
+
+#include "BasicBoard.h"
+#include "HugePages.h"
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+
+
+template<unsigned N, unsigned Bits>
+struct LineTables {
+	typename BasicBoard<N, Bits>::Line shift[BasicBoard<N, Bits>::kLineCount];
+	int score[BasicBoard<N, Bits>::kLineCount];
+	uint32_t mergeScore[BasicBoard<N, Bits>::kLineCount];
+};
+
+template<unsigned N, unsigned Bits>
+static LineTables<N, Bits> sLineStorage;
+
+template<unsigned N, unsigned Bits>
+static LineTables<N, Bits>* sHugeTables = nullptr;
+
+template<unsigned N, unsigned Bits>
+typename BasicBoard<N, Bits>::Line* BasicBoard<N, Bits>::shiftTable = sLineStorage<N, Bits>.shift;
+
+template<unsigned N, unsigned Bits>
+int* BasicBoard<N, Bits>::scoreTable = sLineStorage<N, Bits>.score;
+
+template<unsigned N, unsigned Bits>
+uint32_t* BasicBoard<N, Bits>::mergeScoreTable = sLineStorage<N, Bits>.mergeScore;
+
+template<unsigned N, unsigned Bits>
+int BasicBoard<N, Bits>::sLowestLineScore;
+
+template<unsigned N, unsigned Bits>
+int BasicBoard<N, Bits>::sHighestLineScore;
+
+
+/*
+ * Tile (row, col) lives at bit (row * N + col) * Bits of the grid. A line holds N tiles with
+ * tile i at bit i * Bits, where i counts from the edge tiles are shifted towards.
+ */
+template<unsigned N, unsigned Bits>
+struct GridLayout {
+	typedef typename BasicBoard<N, Bits>::Grid Grid;
+	typedef typename BasicBoard<N, Bits>::Line Line;
+	
+	static const Line kTileMask = (1u << Bits) - 1;
+	static const Line kLineMask = (1u << (N * Bits)) - 1;
+	
+	static inline int makeShift(unsigned row, unsigned col) {
+		return (int)((row * N + col) * Bits);
+	}
+	
+	static inline Tile extractTile(Grid grid, int shift) {
+		return (Tile)((grid >> shift) & kTileMask);
+	}
+	
+	static inline Line extractRow(Grid grid, unsigned row) {
+		return (Line)(grid >> makeShift(row, 0)) & kLineMask;
+	}
+	
+	static inline Line extractCol(Grid grid, unsigned col) {
+		Line ret = 0;
+		for(unsigned row = 0; row < N; row++) {
+			ret |= (Line)extractTile(grid, makeShift(row, col)) << (row * Bits);
+		}
+		return ret;
+	}
+	
+	static inline Grid settingRow(Grid grid, unsigned row, Line line) {
+		grid &= ~((Grid)kLineMask << makeShift(row, 0));
+		return grid | ((Grid)line << makeShift(row, 0));
+	}
+	
+	static inline Grid settingColumn(Grid grid, unsigned col, Line line) {
+		for(unsigned row = 0; row < N; row++) {
+			int shift = makeShift(row, col);
+			grid &= ~((Grid)kTileMask << shift);
+			grid |= (Grid)(line & kTileMask) << shift;
+			line >>= Bits;
+		}
+		return grid;
+	}
+	
+	static inline Line reversingLine(Line line) {
+		Line ret = 0;
+		for(unsigned i = 0; i < N; i++) {
+			ret = (ret << Bits) | (line & kTileMask);
+			line >>= Bits;
+		}
+		return ret;
+	}
+	
+	static inline Grid shiftingTiles(Grid grid, Direction dir) {
+		const Line* table = BasicBoard<N, Bits>::shiftTable;
+		for(unsigned i = 0; i < N; i++) {
+			switch(dir) {
+				case Direction::UP:
+					grid = settingColumn(grid, i, table[extractCol(grid, i)]);
+					break;
+				
+				case Direction::DOWN:
+					grid = settingColumn(grid, i, reversingLine(table[reversingLine(extractCol(grid, i))]));
+					break;
+				
+				case Direction::LEFT:
+					grid = settingRow(grid, i, table[extractRow(grid, i)]);
+					break;
+				
+				case Direction::RIGHT:
+					grid = settingRow(grid, i, reversingLine(table[reversingLine(extractRow(grid, i))]));
+					break;
+			}
+		}
+		return grid;
+	}
+};
+
+
+/**
+ * Move the line tables to huge pages or back to static storage, whichever HugePages asks for.
+ */
+template<unsigned N, unsigned Bits>
+static void placingTables() {
+	LineTables<N, Bits>*& huge = sHugeTables<N, Bits>;
+	LineTables<N, Bits>* tables = nullptr;
+	if(HugePages::isEnabled() && !huge) {
+		huge = (LineTables<N, Bits>*)HugePages::allocate(sizeof(LineTables<N, Bits>));
+		tables = huge;
+	}
+	else if(!HugePages::isEnabled() && huge) {
+		HugePages::release(huge, sizeof(LineTables<N, Bits>));
+		huge = nullptr;
+		tables = &sLineStorage<N, Bits>;
+	}
+	
+	if(tables) {
+		BasicBoard<N, Bits>::shiftTable = tables->shift;
+		BasicBoard<N, Bits>::scoreTable = tables->score;
+		BasicBoard<N, Bits>::mergeScoreTable = tables->mergeScore;
+	}
+}
+
+
+template<unsigned N, unsigned Bits>
+void BasicBoard<N, Bits>::fillShiftTable() {
+	typedef GridLayout<N, Bits> Layout;
+	
+	placingTables<N, Bits>();
+	for(uint32_t line = 0; line < kLineCount; line++) {
+		// Slide tiles towards index 0, merging each equal pair once
+		Tile out[N] = {};
+		unsigned count = 0;
+		bool canMerge = false;
+		uint32_t mergeScore = 0;
+		for(unsigned i = 0; i < N; i++) {
+			Tile tile = (Tile)((line >> (i * Bits)) & Layout::kTileMask);
+			if(tile == TILE_EMPTY) {
+				continue;
+			}
+			
+			if(canMerge && out[count - 1] == tile && tile != kMaxTile) {
+				out[count - 1] = tile + 1;
+				mergeScore += 1u << (tile + 1);
+				canMerge = false;
+			}
+			else {
+				out[count++] = tile;
+				canMerge = true;
+			}
+		}
+		
+		Line cur = 0;
+		for(unsigned i = 0; i < N; i++) {
+			cur |= (Line)out[i] << (i * Bits);
+		}
+		shiftTable[line] = cur;
+		mergeScoreTable[line] = mergeScore;
+	}
+}
+
+
+/**
+ * Same terms as the 4x4 scoreLine in Board.cpp, generalized to lines of N tiles.
+ */
+template<unsigned N>
+static inline int scoreLine(const unsigned* row, const HeuristicWeights& weights) {
+	int score = 0;
+	
+	unsigned big = 0, bigIdx = 0;
+	for(unsigned i = 0; i < N; i++) {
+		if(row[i] > big) {
+			big = row[i];
+			bigIdx = i;
+		}
+		if(row[i] == 0) {
+			score += weights.emptyTile;
+		}
+	}
+	
+	if(bigIdx == 0 || bigIdx == N - 1) {
+		score += weights.bigTileOnEdge;
+	}
+	
+	bool increasing = true, decreasing = true;
+	for(unsigned i = 0; i + 1 < N; i++) {
+		if(row[i] == row[i + 1] + 1 || row[i] + 1 == row[i + 1]) {
+			score += weights.nearMerge;
+		}
+		increasing = increasing && row[i] < row[i + 1];
+		decreasing = decreasing && row[i] > row[i + 1];
+	}
+	
+	if(increasing || decreasing) {
+		score += weights.monotonic;
+	}
+	
+	return score;
+}
+
+
+template<unsigned N, unsigned Bits>
+void BasicBoard<N, Bits>::fillScoreTable(const HeuristicWeights& weights) {
+	sLowestLineScore = INT_MAX;
+	sHighestLineScore = INT_MIN;
+	for(uint32_t line = 0; line < kLineCount; line++) {
+		// Nonempty tiles are bumped by one, as in Board::fillScoreTable
+		unsigned slots[N];
+		for(unsigned i = 0; i < N; i++) {
+			slots[i] = (line >> (i * Bits)) & GridLayout<N, Bits>::kTileMask;
+			if(slots[i] != TILE_EMPTY) {
+				++slots[i];
+			}
+		}
+		scoreTable[line] = scoreLine<N>(slots, weights);
+		sLowestLineScore = std::min(sLowestLineScore, scoreTable[line]);
+		sHighestLineScore = std::max(sHighestLineScore, scoreTable[line]);
+	}
+}
+
+
+template<unsigned N, unsigned Bits>
+BasicBoard<N, Bits>::BasicBoard()
+: mCompressedGrid(0) { }
+
+template<unsigned N, unsigned Bits>
+BasicBoard<N, Bits>::BasicBoard(Grid grid)
+: mCompressedGrid(grid) { }
+
+
+template<unsigned N, unsigned Bits>
+typename BasicBoard<N, Bits>::Grid BasicBoard<N, Bits>::getCompressedGrid() const {
+	return mCompressedGrid;
+}
+
+
+template<unsigned N, unsigned Bits>
+void BasicBoard<N, Bits>::placeTile(Tile tile, unsigned row, unsigned col) {
+	typedef GridLayout<N, Bits> Layout;
+	int shift = Layout::makeShift(row, col);
+	mCompressedGrid = (mCompressedGrid & ~((Grid)Layout::kTileMask << shift)) | ((Grid)tile << shift);
+}
+
+
+template<unsigned N, unsigned Bits>
+unsigned BasicBoard<N, Bits>::findHoles(int* holeShifts) const {
+	typedef GridLayout<N, Bits> Layout;
+	Grid grid = mCompressedGrid;
+	
+	unsigned holeCount = 0;
+	for(int shift = 0; shift < (int)(N * N * Bits); shift += Bits) {
+		if(Layout::extractTile(grid, shift) == TILE_EMPTY) {
+			holeShifts[holeCount++] = shift;
+		}
+	}
+	return holeCount;
+}
+
+
+template<unsigned N, unsigned Bits>
+uint32_t BasicBoard<N, Bits>::holeMask() const {
+	typedef GridLayout<N, Bits> Layout;
+	
+	uint32_t mask = 0;
+	for(unsigned cell = 0; cell < N * N; cell++) {
+		if(Layout::extractTile(mCompressedGrid, cell * Bits) == TILE_EMPTY) {
+			mask |= 1u << cell;
+		}
+	}
+	return mask;
+}
+
+
+template<unsigned N, unsigned Bits>
+Tile BasicBoard<N, Bits>::maxTile() const {
+	typedef GridLayout<N, Bits> Layout;
+	
+	Tile ret = TILE_EMPTY;
+	for(unsigned cell = 0; cell < N * N; cell++) {
+		ret = std::max(ret, Layout::extractTile(mCompressedGrid, cell * Bits));
+	}
+	return ret;
+}
+
+
+template<unsigned N, unsigned Bits>
+void BasicBoard<N, Bits>::placeRandom(std::mt19937& rng, unsigned* pRow, unsigned* pCol, Tile* pTile) {
+	int holeShifts[N * N];
+	unsigned holeCount = findHoles(holeShifts);
+	
+	// 10% chance of spawning a 4, in an evenly chosen hole
+	Tile tile = 1 << (rng() % 10 == 0);
+	if(pTile != nullptr) {
+		*pTile = tile;
+	}
+	
+	int hole = holeShifts[rng() % holeCount];
+	if(pRow != nullptr) {
+		*pRow = (hole / Bits) / N;
+		*pCol = (hole / Bits) % N;
+	}
+	
+	mCompressedGrid |= (Grid)tile << hole;
+}
+
+
+template<unsigned N, unsigned Bits>
+bool BasicBoard<N, Bits>::shiftTiles(Direction dir) {
+	Grid old = mCompressedGrid;
+	mCompressedGrid = GridLayout<N, Bits>::shiftingTiles(old, dir);
+	return mCompressedGrid != old;
+}
+
+
+template<unsigned N, unsigned Bits>
+unsigned BasicBoard<N, Bits>::shiftScore(Direction dir) const {
+	typedef GridLayout<N, Bits> Layout;
+	Grid grid = mCompressedGrid;
+	
+	unsigned score = 0;
+	for(unsigned i = 0; i < N; i++) {
+		switch(dir) {
+			case Direction::UP:
+				score += mergeScoreTable[Layout::extractCol(grid, i)];
+				break;
+			
+			case Direction::DOWN:
+				score += mergeScoreTable[Layout::reversingLine(Layout::extractCol(grid, i))];
+				break;
+			
+			case Direction::LEFT:
+				score += mergeScoreTable[Layout::extractRow(grid, i)];
+				break;
+			
+			case Direction::RIGHT:
+				score += mergeScoreTable[Layout::reversingLine(Layout::extractRow(grid, i))];
+				break;
+		}
+	}
+	return score;
+}
+
+
+template<unsigned N, unsigned Bits>
+bool BasicBoard<N, Bits>::isGameOver() const {
+	for(int i = 0; i < 4; i++) {
+		if(GridLayout<N, Bits>::shiftingTiles(mCompressedGrid, (Direction)i) != mCompressedGrid) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+template<unsigned N, unsigned Bits>
+void BasicBoard<N, Bits>::print() const {
+	typedef GridLayout<N, Bits> Layout;
+	
+	for(unsigned row = 0; row < N; row++) {
+		for(unsigned col = 0; col < N; col++) {
+			Tile tile = Layout::extractTile(mCompressedGrid, Layout::makeShift(row, col));
+			if(tile == TILE_EMPTY) {
+				printf("%11s", ".");
+			}
+			else {
+				printf("%11lu", 1ul << tile);
+			}
+		}
+		printf("\n");
+	}
+	printf("\n");
+}
+
+
+template<unsigned N, unsigned Bits>
+int BasicBoard<N, Bits>::estimateScore() const {
+	return estimateScore(lineScore());
+}
+
+
+template<unsigned N, unsigned Bits>
+int BasicBoard<N, Bits>::estimateScore(int lineScore) const {
+	if(isGameOver()) {
+		return -999999;
+	}
+	return lineScore;
+}
+
+
+template<unsigned N, unsigned Bits>
+void BasicBoard<N, Bits>::scoreBounds(int* lower, int* upper) {
+	*lower = std::min(2 * (int)N * sLowestLineScore, -999999);
+	*upper = std::max(2 * (int)N * sHighestLineScore, -999999);
+}
+
+
+template<unsigned N, unsigned Bits>
+void BasicBoard<N, Bits>::estimateScores(const BasicBoard* boards, size_t count, int* scores) {
+	for(size_t i = 0; i < count; i++) {
+		scores[i] = boards[i].estimateScore();
+	}
+}
+
+
+template<unsigned N, unsigned Bits>
+int BasicBoard<N, Bits>::lineScore() const {
+	typedef GridLayout<N, Bits> Layout;
+	
+	int score = 0;
+	for(unsigned i = 0; i < N; i++) {
+		score += scoreTable[Layout::extractRow(mCompressedGrid, i)];
+		score += scoreTable[Layout::extractCol(mCompressedGrid, i)];
+	}
+	return score;
+}
+
+
+template<unsigned N, unsigned Bits>
+int BasicBoard<N, Bits>::updatedLineScore(int lineScore, BasicBoard after) const {
+	typedef GridLayout<N, Bits> Layout;
+	Grid grid = mCompressedGrid, next = after.mCompressedGrid;
+	
+	// Swap the scores of just the rows and columns that differ
+	for(unsigned i = 0; i < N; i++) {
+		Line oldRow = Layout::extractRow(grid, i), newRow = Layout::extractRow(next, i);
+		if(oldRow != newRow) {
+			lineScore += scoreTable[newRow] - scoreTable[oldRow];
+		}
+		Line oldCol = Layout::extractCol(grid, i), newCol = Layout::extractCol(next, i);
+		if(oldCol != newCol) {
+			lineScore += scoreTable[newCol] - scoreTable[oldCol];
+		}
+	}
+	return lineScore;
+}
+
+
+template<unsigned N, unsigned Bits>
+unsigned BasicBoard<N, Bits>::allPlaces(BasicBoard* places) const {
+	Grid grid = mCompressedGrid;
+	unsigned holeCount = 0;
+	
+	// A 2 and then a 4 in each hole, in holeMask() order
+	for(uint32_t holes = holeMask(); holes; holes &= holes - 1) {
+		int shift = __builtin_ctz(holes) * Bits;
+		places++->mCompressedGrid = grid | ((Grid)TILE_2 << shift);
+		places++->mCompressedGrid = grid | ((Grid)TILE_4 << shift);
+		++holeCount;
+	}
+	return holeCount;
+}
+
+
+template<unsigned N, unsigned Bits>
+void BasicBoard<N, Bits>::allShifts(BasicBoard* shifts) const {
+	Grid grid = mCompressedGrid;
+	for(int i = 0; i < 4; i++) {
+		shifts[i].mCompressedGrid = GridLayout<N, Bits>::shiftingTiles(grid, (Direction)i);
+		if(shifts[i].mCompressedGrid == grid) {
+			shifts[i].mCompressedGrid = 0;
+		}
+	}
+}
+
+
+template<unsigned N, unsigned Bits>
+bool BasicBoard<N, Bits>::isEmpty() const {
+	return mCompressedGrid == 0;
+}
+
+
+template class BasicBoard<4, 5>;
+template class BasicBoard<5, 4>;
@@ -0,0 +1,86 @@
+//
+//  BasicBoard.h
+//  CAP4053_Minimax
+//
+//  Created by kTeam on 10/19/26.
+//  Copyright © 2026 kTeam. All rights reserved.
+//
+
+#ifndef MM_BASICBOARD_H
+#define MM_BASICBOARD_H
+
+#include <cstdint>
+#include <random>
+#include <type_traits>
+#include "Board.h"
+#include "Direction.h"
+
+
+/**
+ * Generic board of N x N tiles stored in Bits bits each, packed row-major into a uint64_t when
+ * they fit and an unsigned __int128 otherwise. Lines of N tiles are looked up in tables with
+ * 2^(N * Bits) entries, so N * Bits is limited to 20 (1M entries per table).
+ *
+ * Instantiated for 4x4 boards with 5-bit tiles (up to 2^31) and 5x5 boards with 4-bit tiles.
+ * BasicBoard<4, 4> is the specialized Board from Board.h. Tiles use the same exponent encoding
+ * as Board, and a pair of the largest representable tile never merges.
+ */
+template<unsigned N, unsigned Bits>
+class BasicBoard {
+public:
+	static_assert(N * Bits <= 20, "Line tables would be too large");
+	static_assert(Bits <= 5, "Merge scores of larger tiles don't fit in 32 bits");
+	
+	typedef typename std::conditional<N * N * Bits <= 64, uint64_t, unsigned __int128>::type Grid;
+	typedef uint32_t Line;
+	
+	static const unsigned kSize = N;
+	static const unsigned kTileBits = Bits;
+	static const unsigned kLineCount = 1u << (N * Bits);
+	static const Tile kMaxTile = (Tile)((1u << Bits) - 1);
+	
+	/**
+	 * Placed like Board::lineTable: fillShiftTable() moves them to huge pages while HugePages
+	 * is enabled, so fill the scores after it.
+	 */
+	static Line* shiftTable;
+	static int* scoreTable;
+	static uint32_t* mergeScoreTable;
+	static void fillShiftTable();
+	static void fillScoreTable(const HeuristicWeights& weights = HeuristicWeights());
+	
+	BasicBoard();
+	explicit BasicBoard(Grid grid);
+	
+	Grid getCompressedGrid() const;
+	
+	void placeTile(Tile tile, unsigned row, unsigned col);
+	unsigned findHoles(int* holeShifts) const;
+	uint32_t holeMask() const;
+	Tile maxTile() const;
+	void placeRandom(std::mt19937& rng, unsigned* pRow = nullptr, unsigned* pCol = nullptr, Tile* pTile = nullptr);
+	
+	bool shiftTiles(Direction dir);
+	unsigned shiftScore(Direction dir) const;
+	
+	bool isGameOver() const;
+	void print() const;
+	
+	int estimateScore() const;
+	int estimateScore(int lineScore) const;
+	int lineScore() const;
+	int updatedLineScore(int lineScore, BasicBoard after) const;
+	static void estimateScores(const BasicBoard* boards, size_t count, int* scores);
+	static void scoreBounds(int* lower, int* upper);
+	unsigned allPlaces(BasicBoard* places) const;
+	void allShifts(BasicBoard* shifts) const;
+	bool isEmpty() const;
+
+private:
+	static int sLowestLineScore;
+	static int sHighestLineScore;
+	
+	Grid mCompressedGrid;
+};
+
+#endif /* MM_BASICBOARD_H */
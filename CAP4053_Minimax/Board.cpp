@@ -7,14 +7,30 @@
 //
 
 #include "Board.h"
+#include <algorithm>
+#include <climits>
+#include <cstddef>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include "BoardPrivate.h"
+#include "Evaluator.h"
+#include "HugePages.h"
+#include "Trace.h"
 
 
-uint16_t Board::shiftTable[65536];
-int Board::scoreTable[65536];
+static Board::LineInfo sLineStorage[65536];
+static uint32_t sMergeScoreStorage[65536];
+static void* sHugeTables = nullptr;
+
+Board::LineInfo* Board::lineTable = sLineStorage;
+uint32_t* Board::mergeScoreTable = sMergeScoreStorage;
+const Evaluator* Board::sEvaluator = nullptr;
+int Board::sLowestLineScore = 0;
+int Board::sHighestLineScore = 0;
+
+static_assert(sizeof(Board::LineInfo) == 8, "LineInfo entries should stay packed in 8 bytes");
 
 
 static inline CompressedGrid insertingTile(CompressedGrid grid, int shift, CompressedGrid tile) {
@@ -76,9 +92,40 @@ static inline uint16_t shiftingLine(uint16_t line, int dst, int delta = MAKE_COL
 }
 
 
+static inline uint16_t reversingLine(uint16_t line) {
+	line = ((line & 0x00ff) << 8) | ((line & 0xff00) >> 8);
+	line = ((line & 0x0f0f) << 4) | ((line & 0xf0f0) >> 4);
+	return line;
+}
+
+
+/**
+ * Move the line tables to huge pages or back to static storage, whichever HugePages asks for.
+ * Both tables share one allocation, which fits in a single huge page.
+ */
+static void placingTables() {
+	const size_t bytes = sizeof(sLineStorage) + sizeof(sMergeScoreStorage);
+	if(HugePages::isEnabled() && !sHugeTables) {
+		sHugeTables = HugePages::allocate(bytes);
+		if(sHugeTables) {
+			Board::lineTable = (Board::LineInfo*)sHugeTables;
+			Board::mergeScoreTable = (uint32_t*)(Board::lineTable + 65536);
+		}
+	}
+	else if(!HugePages::isEnabled() && sHugeTables) {
+		Board::lineTable = sLineStorage;
+		Board::mergeScoreTable = sMergeScoreStorage;
+		HugePages::release(sHugeTables, bytes);
+		sHugeTables = nullptr;
+	}
+}
+
+
 void Board::fillShiftTable() {
+	placingTables();
 	for(uint32_t line = 0; line < 65536; ++line) {
 		uint16_t cur = line;
+		uint32_t mergeScore = 0;
 		
 		// Skip past all holes
 		for(int shift = 0; shift < (4 * TILE_BITS); shift += TILE_BITS) {
@@ -101,7 +148,8 @@ void Board::fillShiftTable() {
 		// Only run for tiles in the first three slots
 		for(int shift = 0; shift < (3 * TILE_BITS); shift += TILE_BITS) {
 			unsigned tile = EXTRACT_TILE(cur, shift);
-			if(tile != TILE_EMPTY && tile == EXTRACT_TILE(cur, shift + TILE_BITS)) {
+			// A pair of the largest tiles can't merge, since the result wouldn't fit in a nybble
+			if(tile != TILE_EMPTY && tile != TILE_32768 && tile == EXTRACT_TILE(cur, shift + TILE_BITS)) {
 				/*
 				 *   X X X X -> X X X X
 				 *   A A A A -> B B 0 0
@@ -110,25 +158,35 @@ void Board::fillShiftTable() {
 				 */
 				cur = (cur & ~(TILE_MASK << shift)) | ((tile + 1) << shift);
 				cur = shiftingLine(cur, shift + TILE_BITS);
+				mergeScore += TILE_VALUE(tile + 1);
 			}
 		}
 		
-		// Store result of shift
-		shiftTable[line] = cur;
+		// Store result of shift and the points earned by its merges
+		lineTable[line].left = cur;
+		mergeScoreTable[line] = mergeScore;
+	}
+	
+	// Shifting right is shifting the reversed line left, so fill it in once every left shift is known
+	for(uint32_t line = 0; line < 65536; ++line) {
+		LineInfo& info = lineTable[line];
+		info.right = reversingLine(lineTable[reversingLine(line)].left);
+		
+		int32_t flags = 0;
+		if(info.left != line) {
+			flags |= LineInfo::kMovesLeft;
+		}
+		if(info.right != line) {
+			flags |= LineInfo::kMovesRight;
+		}
+		info.scoreAndFlags = (info.scoreAndFlags & ~0xff) | flags;
 	}
-}
-
-
-static inline uint16_t reversingLine(uint16_t line) {
-	line = ((line & 0x00ff) << 8) | ((line & 0xff00) >> 8);
-	line = ((line & 0x0f0f) << 4) | ((line & 0xf0f0) >> 4);
-	return line;
 }
 
 
 static inline CompressedGrid shiftingTilesUp(CompressedGrid grid) {
 	for(unsigned col = 0; col < 4; col++) {
-		grid = settingColumn(grid, col, Board::shiftTable[extractCol(grid, col)]);
+		grid = settingColumn(grid, col, Board::lineTable[extractCol(grid, col)].left);
 	}
 	return grid;
 }
@@ -136,14 +194,14 @@ static inline CompressedGrid shiftingTilesUp(CompressedGrid grid) {
 
 static inline CompressedGrid shiftingTilesDown(CompressedGrid grid) {
 	for(unsigned col = 0; col < 4; col++) {
-		grid = settingColumn(grid, col, reversingLine(Board::shiftTable[reversingLine(extractCol(grid, col))]));
+		grid = settingColumn(grid, col, Board::lineTable[extractCol(grid, col)].right);
 	}
 	return grid;
 }
 
 static inline CompressedGrid shiftingTilesLeft(CompressedGrid grid) {
 	for(unsigned row = 0; row < 4; row++) {
-		grid = settingRow(grid, row, Board::shiftTable[extractRow(grid, row)]);
+		grid = settingRow(grid, row, Board::lineTable[extractRow(grid, row)].left);
 	}
 	return grid;
 }
@@ -151,15 +209,309 @@ static inline CompressedGrid shiftingTilesLeft(CompressedGrid grid) {
 
 static inline CompressedGrid shiftingTilesRight(CompressedGrid grid) {
 	for(unsigned row = 0; row < 4; row++) {
-		grid = settingRow(grid, row, reversingLine(Board::shiftTable[reversingLine(extractRow(grid, row))]));
+		grid = settingRow(grid, row, Board::lineTable[extractRow(grid, row)].right);
+	}
+	return grid;
+}
+
+
+static inline int scoringGrid(CompressedGrid grid) {
+	int score = 0;
+	
+	// Score horizontal stripes
+	for(int r = 0; r < 4; r++) {
+		score += Board::lineTable[extractRow(grid, r)].score();
+	}
+	
+	// Score vertical stripes
+	for(int c = 0; c < 4; c++) {
+		score += Board::lineTable[extractCol(grid, c)].score();
+	}
+	
+	return score;
+}
+
+
+static inline bool checkingMoves(CompressedGrid grid) {
+	// Any row or column that can shift either way means some move changes the board
+	int32_t flags = 0;
+	for(unsigned i = 0; i < 4; i++) {
+		flags |= Board::lineTable[extractRow(grid, i)].scoreAndFlags;
+		flags |= Board::lineTable[extractCol(grid, i)].scoreAndFlags;
+	}
+	return (flags & (Board::LineInfo::kMovesLeft | Board::LineInfo::kMovesRight)) != 0;
+}
+
+
+static inline unsigned findingHoles(CompressedGrid grid, int* holeShifts) {
+	unsigned holeCount = 0;
+	for(CompressedGrid empty = emptyNybbles(grid); empty; empty &= empty - 1) {
+		holeShifts[holeCount++] = __builtin_ctzll(empty);
+	}
+	return holeCount;
+}
+
+
+/*
+ * The hot Board operations are built in several ISA variants and called through a dispatch
+ * table picked once at startup, so one binary runs well on every machine we deploy to. Each
+ * table entry is a whole operation rather than a single line lookup, so the indirect call is
+ * paid once per operation and everything inside it stays inlined.
+ */
+struct BoardKernels {
+	const char* name;
+	bool (*isSupported)();
+	CompressedGrid (*shift[4])(CompressedGrid grid);
+	void (*allShifts)(CompressedGrid grid, CompressedGrid* shifts);
+	bool (*isGameOver)(CompressedGrid grid);
+	unsigned (*findHoles)(CompressedGrid grid, int* holeShifts);
+	int (*evaluate)(CompressedGrid grid);
+};
+
+
+#define MM_DEFINE_KERNELS(prefix, target, up, down, left, right, moves, holes, evaluating) \
+	target static CompressedGrid prefix##ShiftUp(CompressedGrid grid) { return up(grid); } \
+	target static CompressedGrid prefix##ShiftDown(CompressedGrid grid) { return down(grid); } \
+	target static CompressedGrid prefix##ShiftLeft(CompressedGrid grid) { return left(grid); } \
+	target static CompressedGrid prefix##ShiftRight(CompressedGrid grid) { return right(grid); } \
+	target static void prefix##AllShifts(CompressedGrid grid, CompressedGrid* shifts) { \
+		shifts[0] = up(grid); \
+		shifts[1] = down(grid); \
+		shifts[2] = left(grid); \
+		shifts[3] = right(grid); \
+	} \
+	target static bool prefix##IsGameOver(CompressedGrid grid) { return !moves(grid); } \
+	target static unsigned prefix##FindHoles(CompressedGrid grid, int* holeShifts) { return holes(grid, holeShifts); } \
+	target static int prefix##Evaluate(CompressedGrid grid) { return evaluating(grid); }
+
+#define MM_KERNEL_TABLE(name, prefix, isSupported) \
+	{name, isSupported, \
+	 {prefix##ShiftUp, prefix##ShiftDown, prefix##ShiftLeft, prefix##ShiftRight}, \
+	 prefix##AllShifts, prefix##IsGameOver, prefix##FindHoles, prefix##Evaluate}
+
+
+// Portable baseline, the original loops over nybbles
+static bool scalarSupported() {
+	return true;
+}
+
+MM_DEFINE_KERNELS(scalar, , shiftingTilesUp, shiftingTilesDown, shiftingTilesLeft, shiftingTilesRight,
+	checkingMoves, findingHoles, scoringGrid)
+
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+
+#define MM_TARGET_SSE4 __attribute__((target("sse4.1,popcnt")))
+#define MM_TARGET_BMI2 __attribute__((target("bmi,bmi2")))
+#define MM_TARGET_AVX2 __attribute__((target("avx2,bmi,bmi2")))
+
+static const CompressedGrid kColumnMask = 0x000f000f000f000f;
+
+/*
+ * SSE4: the 16 tiles are spread into the 16 bytes of an XMM register, where one PSHUFB
+ * transposes the grid, so columns become rows and every direction and every line score goes
+ * through the row tables. Finding the holes with PCMPEQB and PMOVMSKB was slower than the SWAR
+ * mask, which never leaves the general registers, so holes use the SWAR mask.
+ */
+MM_TARGET_SSE4 static inline __m128i spreadingTiles(CompressedGrid grid) {
+	// Each byte of the grid widens to a 16-bit lane, and its high nybble moves up into the
+	// lane's high byte
+	__m128i pairs = _mm_cvtepu8_epi16(_mm_cvtsi64_si128((long long)grid));
+	return _mm_and_si128(_mm_or_si128(pairs, _mm_slli_epi16(pairs, 4)), _mm_set1_epi16(0x0f0f));
+}
+
+MM_TARGET_SSE4 static inline CompressedGrid packingTiles(__m128i tiles) {
+	// Each pair of bytes becomes low + 16 * high in a 16-bit lane, then a byte of its own
+	__m128i pairs = _mm_maddubs_epi16(tiles, _mm_set1_epi16(0x1001));
+	return (CompressedGrid)_mm_cvtsi128_si64(_mm_packus_epi16(pairs, pairs));
+}
+
+MM_TARGET_SSE4 static inline CompressedGrid shufflingTranspose(CompressedGrid grid) {
+	// Byte row * 4 + col takes the tile from byte col * 4 + row
+	const __m128i kTranspose = _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+	return packingTiles(_mm_shuffle_epi8(spreadingTiles(grid), kTranspose));
+}
+
+MM_TARGET_SSE4 static inline CompressedGrid transposedShiftingUp(CompressedGrid grid) {
+	return shufflingTranspose(shiftingTilesLeft(shufflingTranspose(grid)));
+}
+
+MM_TARGET_SSE4 static inline CompressedGrid transposedShiftingDown(CompressedGrid grid) {
+	return shufflingTranspose(shiftingTilesRight(shufflingTranspose(grid)));
+}
+
+MM_TARGET_SSE4 static inline bool transposedMoves(CompressedGrid grid) {
+	CompressedGrid transposed = shufflingTranspose(grid);
+	int32_t flags = 0;
+	for(int i = 0; i < 4; i++) {
+		flags |= Board::lineTable[extractRow(grid, i)].scoreAndFlags;
+		flags |= Board::lineTable[extractRow(transposed, i)].scoreAndFlags;
+	}
+	return (flags & (Board::LineInfo::kMovesLeft | Board::LineInfo::kMovesRight)) != 0;
+}
+
+MM_TARGET_SSE4 static inline int transposedScoring(CompressedGrid grid) {
+	CompressedGrid transposed = shufflingTranspose(grid);
+	int score = 0;
+	for(int i = 0; i < 4; i++) {
+		score += Board::lineTable[extractRow(grid, i)].score();
+		score += Board::lineTable[extractRow(transposed, i)].score();
+	}
+	return score;
+}
+
+static bool sse4Supported() {
+	return __builtin_cpu_supports("sse4.1") && __builtin_cpu_supports("popcnt");
+}
+
+MM_DEFINE_KERNELS(sse4, MM_TARGET_SSE4, transposedShiftingUp, transposedShiftingDown, shiftingTilesLeft,
+	shiftingTilesRight, transposedMoves, findingHoles, transposedScoring)
+
+
+/*
+ * BMI2: PEXT gathers a column into a 16-bit line and PDEP scatters it back. The hole mask walk
+ * compiles to TZCNT and BLSR.
+ */
+MM_TARGET_BMI2 static inline uint16_t pextColumn(CompressedGrid grid, unsigned col) {
+	return (uint16_t)_pext_u64(grid, kColumnMask << MAKE_COL_SHIFT(col));
+}
+
+MM_TARGET_BMI2 static inline CompressedGrid pdepColumn(CompressedGrid grid, unsigned col, uint16_t line) {
+	CompressedGrid mask = kColumnMask << MAKE_COL_SHIFT(col);
+	return (grid & ~mask) | _pdep_u64(line, mask);
+}
+
+MM_TARGET_BMI2 static inline CompressedGrid pextShiftingUp(CompressedGrid grid) {
+	for(unsigned col = 0; col < 4; col++) {
+		grid = pdepColumn(grid, col, Board::lineTable[pextColumn(grid, col)].left);
+	}
+	return grid;
+}
+
+MM_TARGET_BMI2 static inline CompressedGrid pextShiftingDown(CompressedGrid grid) {
+	for(unsigned col = 0; col < 4; col++) {
+		grid = pdepColumn(grid, col, Board::lineTable[pextColumn(grid, col)].right);
 	}
 	return grid;
 }
 
+MM_TARGET_BMI2 static inline bool pextMoves(CompressedGrid grid) {
+	int32_t flags = 0;
+	for(unsigned i = 0; i < 4; i++) {
+		flags |= Board::lineTable[extractRow(grid, i)].scoreAndFlags;
+		flags |= Board::lineTable[pextColumn(grid, i)].scoreAndFlags;
+	}
+	return (flags & (Board::LineInfo::kMovesLeft | Board::LineInfo::kMovesRight)) != 0;
+}
+
+MM_TARGET_BMI2 static inline int pextScoring(CompressedGrid grid) {
+	int score = 0;
+	for(unsigned i = 0; i < 4; i++) {
+		score += Board::lineTable[extractRow(grid, i)].score();
+		score += Board::lineTable[pextColumn(grid, i)].score();
+	}
+	return score;
+}
+
+static bool bmi2Supported() {
+	return __builtin_cpu_supports("bmi") && __builtin_cpu_supports("bmi2");
+}
+
+MM_DEFINE_KERNELS(bmi2, MM_TARGET_BMI2, pextShiftingUp, pextShiftingDown, shiftingTilesLeft, shiftingTilesRight,
+	pextMoves, findingHoles, pextScoring)
+
+
+/*
+ * AVX2: the BMI2 kernels, except that evaluation fetches all 8 line scores with one gather. The
+ * gather reads the packed score and flags word of each 8-byte LineInfo, and the flags are
+ * shifted out afterwards.
+ */
+MM_TARGET_AVX2 static inline int gatherScoring(CompressedGrid grid) {
+	__m256i lines = _mm256_setr_epi32(
+		extractRow(grid, 0), extractRow(grid, 1), extractRow(grid, 2), extractRow(grid, 3),
+		pextColumn(grid, 0), pextColumn(grid, 1), pextColumn(grid, 2), pextColumn(grid, 3)
+	);
+	const int* packed = (const int*)((const char*)Board::lineTable + offsetof(Board::LineInfo, scoreAndFlags));
+	__m256i scores = _mm256_srai_epi32(_mm256_i32gather_epi32(packed, lines, sizeof(Board::LineInfo)), 8);
+	__m128i sum = _mm_add_epi32(_mm256_castsi256_si128(scores), _mm256_extracti128_si256(scores, 1));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+	sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtsi128_si32(sum);
+}
+
+static bool avx2Supported() {
+	return __builtin_cpu_supports("avx2") && bmi2Supported();
+}
+
+MM_DEFINE_KERNELS(avx2, MM_TARGET_AVX2, pextShiftingUp, pextShiftingDown, shiftingTilesLeft, shiftingTilesRight,
+	pextMoves, findingHoles, gatherScoring)
+
+#endif /* __x86_64__ */
+
+
+// Best variant first
+static const BoardKernels kKernelVariants[] = {
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+	MM_KERNEL_TABLE("avx2", avx2, avx2Supported),
+	MM_KERNEL_TABLE("bmi2", bmi2, bmi2Supported),
+	MM_KERNEL_TABLE("sse4", sse4, sse4Supported),
+#endif
+	MM_KERNEL_TABLE("scalar", scalar, scalarSupported)
+};
+
+static const BoardKernels* pickingKernels() {
+	for(const BoardKernels& kernels : kKernelVariants) {
+		if(kernels.isSupported()) {
+			return &kernels;
+		}
+	}
+	return &kKernelVariants[sizeof(kKernelVariants) / sizeof(*kKernelVariants) - 1];
+}
+
+/**
+ * The variant in use. Other static initializers may already shift boards, so it's picked on
+ * first use rather than in an initialization order they can't rely on.
+ */
+static const BoardKernels*& selectedKernels() {
+	static const BoardKernels* sKernels = pickingKernels();
+	return sKernels;
+}
+
+
+const char* Board::kernelName() {
+	return selectedKernels()->name;
+}
+
+
+bool Board::selectKernels(const char* name) {
+	for(const BoardKernels& kernels : kKernelVariants) {
+		if(strcmp(kernels.name, name) == 0) {
+			if(!kernels.isSupported()) {
+				std::cerr << "Board kernels " << name << " aren't supported by this CPU" << std::endl;
+				return false;
+			}
+			selectedKernels() = &kernels;
+			return true;
+		}
+	}
+	
+	std::cerr << "Unknown board kernels " << name << std::endl;
+	return false;
+}
 
-Board::Board()
+
+Board::BasicBoard()
 : mCompressedGrid(0) { }
 
+Board::BasicBoard(CompressedGrid grid)
+: mCompressedGrid(grid) { }
+
+
+CompressedGrid Board::getCompressedGrid() const {
+	return mCompressedGrid;
+}
+
 
 void Board::placeTile(Tile tile, unsigned row, unsigned col) {
 	mCompressedGrid = settingTile(mCompressedGrid, row, col, tile);
@@ -167,24 +519,13 @@ void Board::placeTile(Tile tile, unsigned row, unsigned col) {
 
 
 unsigned Board::findHoles(int* holeShifts) const {
-	// Operate on a local copy of the grid, hopefully in a register
-	uint64_t grid = mCompressedGrid;
-	
 	// Find all of the holes into which a tile can be placed
-	unsigned holeCount = 0;
-	for(int shift = MAKE_SHIFT(0, 0); shift <= MAKE_SHIFT(3, 3); shift = MAKE_RIGHT(shift)) {
-		if(EXTRACT_TILE(grid, shift) == TILE_EMPTY) {
-			holeShifts[holeCount++] = shift;
-		}
-	}
-	
-	return holeCount;
+	return selectedKernels()->findHoles(mCompressedGrid, holeShifts);
 }
 
 
 void Board::placeRandom(unsigned* pRow, unsigned* pCol, Tile* pTile) {
-	int holeShifts[16];
-	unsigned holeCount = findHoles(holeShifts);
+	CompressedGrid empty = emptyNybbles(mCompressedGrid);
 	
 	// Generate random tile value (10% chance of spawning a 4)...
 	unsigned tile = 1 << (rand() % 10 == 0);
@@ -193,7 +534,7 @@ void Board::placeRandom(unsigned* pRow, unsigned* pCol, Tile* pTile) {
 	}
 	
 	// ...and pick which hole to place it in with even distribution.
-	int hole = holeShifts[rand() % holeCount];
+	int hole = selectingHole(empty, rand() % __builtin_popcountll(empty));
 	if(pRow != nullptr) {
 		*pRow = GET_SHIFT_ROW(hole);
 		*pCol = GET_SHIFT_COL(hole);
@@ -204,17 +545,36 @@ void Board::placeRandom(unsigned* pRow, unsigned* pCol, Tile* pTile) {
 }
 
 
+void Board::placeRandom(std::mt19937& rng, unsigned* pRow, unsigned* pCol, Tile* pTile) {
+	CompressedGrid empty = emptyNybbles(mCompressedGrid);
+	
+	// Same distribution as above, but drawn from the caller's generator so threads don't share state
+	unsigned tile = 1 << (rng() % 10 == 0);
+	if(pTile != nullptr) {
+		*pTile = tile;
+	}
+	
+	int hole = selectingHole(empty, rng() % __builtin_popcountll(empty));
+	if(pRow != nullptr) {
+		*pRow = GET_SHIFT_ROW(hole);
+		*pCol = GET_SHIFT_COL(hole);
+	}
+	
+	mCompressedGrid = insertingTile(mCompressedGrid, hole, tile);
+}
+
+
 bool Board::shiftTiles(Direction dir) {
 	switch(dir) {
 		case Direction::UP:
 			return shiftTilesUp();
-			
+		
 		case Direction::DOWN:
 			return shiftTilesDown();
-			
+		
 		case Direction::LEFT:
 			return shiftTilesLeft();
-			
+		
 		case Direction::RIGHT:
 			return shiftTilesRight();
 	}
@@ -222,53 +582,66 @@ bool Board::shiftTiles(Direction dir) {
 
 bool Board::shiftTilesUp() {
 	CompressedGrid old = mCompressedGrid;
-	mCompressedGrid = shiftingTilesUp(old);
+	mCompressedGrid = selectedKernels()->shift[(int)Direction::UP](old);
 	return mCompressedGrid != old;
 }
 
 bool Board::shiftTilesDown() {
 	CompressedGrid old = mCompressedGrid;
-	mCompressedGrid = shiftingTilesDown(old);
+	mCompressedGrid = selectedKernels()->shift[(int)Direction::DOWN](old);
 	return mCompressedGrid != old;
 }
 
 bool Board::shiftTilesLeft() {
 	CompressedGrid old = mCompressedGrid;
-	mCompressedGrid = shiftingTilesLeft(old);
+	mCompressedGrid = selectedKernels()->shift[(int)Direction::LEFT](old);
 	return mCompressedGrid != old;
 }
 
 bool Board::shiftTilesRight() {
 	CompressedGrid old = mCompressedGrid;
-	mCompressedGrid = shiftingTilesRight(old);
+	mCompressedGrid = selectedKernels()->shift[(int)Direction::RIGHT](old);
 	return mCompressedGrid != old;
 }
 
 
-bool Board::isGameOver() const {
+unsigned Board::shiftScore(Direction dir) const {
 	CompressedGrid grid = mCompressedGrid;
+	unsigned score = 0;
 	
-	if(shiftingTilesUp(grid) != grid) {
-		return false;
-	}
-	
-	if(shiftingTilesDown(grid) != grid) {
-		return false;
-	}
-	
-	if(shiftingTilesLeft(grid) != grid) {
-		return false;
-	}
-	
-	if(shiftingTilesRight(grid) != grid) {
-		return false;
+	// Points earned are the values of all tiles created by merging
+	for(unsigned i = 0; i < 4; i++) {
+		switch(dir) {
+			case Direction::UP:
+				score += Board::mergeScoreTable[extractCol(grid, i)];
+				break;
+			
+			case Direction::DOWN:
+				score += Board::mergeScoreTable[reversingLine(extractCol(grid, i))];
+				break;
+			
+			case Direction::LEFT:
+				score += Board::mergeScoreTable[extractRow(grid, i)];
+				break;
+			
+			case Direction::RIGHT:
+				score += Board::mergeScoreTable[reversingLine(extractRow(grid, i))];
+				break;
+		}
 	}
 	
-	return true;
+	return score;
+}
+
+
+bool Board::isGameOver() const {
+	return selectedKernels()->isGameOver(mCompressedGrid);
 }
 
 
 void Board::print() const {
+	MM_TRACE_SPAN("Board::print");
+	
 	// Operate on a local copy of the grid, hopefully in a register
 	CompressedGrid grid = mCompressedGrid;
 	
@@ -321,7 +694,26 @@ void Board::print() const {
 }
 
 
-static inline int scoreLine(uint_fast8_t* row) {
+bool HeuristicWeights::parse(const char* text) {
+	int values[4];
+	int consumed = 0;
+	if(sscanf(text, "%d,%d,%d,%d%n", &values[0], &values[1], &values[2], &values[3], &consumed) != 4 ||
+	   text[consumed] != '\0'
+	) {
+		return false;
+	}
+	
+	emptyTile = values[0];
+	bigTileOnEdge = values[1];
+	nearMerge = values[2];
+	monotonic = values[3];
+	return true;
+}
+
+
+static const int kMaximumLineScore = (1 << 23) - 1;
+
+static inline int scoreLine(uint_fast8_t* row, const HeuristicWeights& weights) {
 	int score = 0;
 	
 	// Find biggest tile and its index in the line
@@ -336,19 +728,19 @@ static inline int scoreLine(uint_fast8_t* row) {
 		
 		if(cur == TILE_EMPTY) {
 			// It's good to have empty tiles
-			score += 500;
+			score += weights.emptyTile;
 		}
 	}
 	
 	// Best if the largest tile is on the edge
 	if(bigIdx == 0 || bigIdx == 3) {
-		score += 2400;
+		score += weights.bigTileOnEdge;
 	}
 	
 	// Check for tiles that can almost be merged
 	for(int i = 0; i < 3; i++) {
 		if(row[i] == row[i+1] + 1 || row[i] == row[i+1] - 1) {
-			score += 80;
+			score += weights.nearMerge;
 		}
 	}
 	
@@ -356,14 +748,17 @@ static inline int scoreLine(uint_fast8_t* row) {
 	if((row[0] > row[1] && row[1] > row[2] && row[2] > row[3]) ||
 	   (row[0] < row[1] && row[1] < row[2] && row[2] < row[3])
 	) {
-		score += 1500;
+		score += weights.monotonic;
 	}
 	
 	return score;
 }
 
 
-void Board::fillScoreTable() {
+void Board::fillScoreTable(const HeuristicWeights& weights) {
+	bool clamped = false;
+	sLowestLineScore = INT_MAX;
+	sHighestLineScore = INT_MIN;
 	for(uint32_t line = 0; line < 65536; line++) {
 		uint16_t cur = line;
 		
@@ -377,74 +772,184 @@ void Board::fillScoreTable() {
 			cur >>= TILE_BITS;
 		}
 		
-		// Score the slots and save it in the table
-		scoreTable[line] = scoreLine(slots);
+		// Score the slots and save it in the table, which only has room for 24 bits of score
+		int score = scoreLine(slots, weights);
+		if(score > kMaximumLineScore || score < -kMaximumLineScore) {
+			score = score > 0 ? kMaximumLineScore : -kMaximumLineScore;
+			clamped = true;
+		}
+		LineInfo& info = lineTable[line];
+		info.scoreAndFlags = (int32_t)((uint32_t)score << 8) | info.flags();
+		sLowestLineScore = std::min(sLowestLineScore, score);
+		sHighestLineScore = std::max(sHighestLineScore, score);
+	}
+	
+	if(clamped) {
+		std::cerr << "Heuristic weights are too large, some line scores were clamped" << std::endl;
 	}
 }
 
 
+void Board::setEvaluator(const Evaluator* evaluator) {
+	sEvaluator = evaluator;
+}
+
+
+uint64_t Board::heuristicVersion() {
+	if(sEvaluator) {
+		return sEvaluator->version();
+	}
+	
+	// FNV-1a over the score table, so any change to the heuristic changes the version
+	uint64_t hash = 0xcbf29ce484222325;
+	for(uint32_t line = 0; line < 65536; line++) {
+		uint32_t score = (uint32_t)lineTable[line].score();
+		for(int i = 0; i < 4; i++) {
+			hash = (hash ^ (score & 0xff)) * 0x100000001b3;
+			score >>= 8;
+		}
+	}
+	return hash;
+}
+
+
 int Board::estimateScore() const {
 	if(isGameOver()) {
 		return -999999;
 	}
 	
 	CompressedGrid grid = mCompressedGrid;
-	int score = 0;
+	if(sEvaluator) {
+		return sEvaluator->evaluate(grid);
+	}
 	
-	// Score horizontal stripes
-	for(int r = 0; r < 4; r++) {
-		int rowScore = Board::scoreTable[extractRow(grid, r)];
-		score += rowScore;
+	// Sum the scores of every row and column
+	return selectedKernels()->evaluate(grid);
+}
+
+
+int Board::estimateScore(int lineScore) const {
+	if(isGameOver()) {
+		return -999999;
 	}
 	
-	// Score vertical stripes
-	for(int c = 0; c < 4; c++) {
-		int colScore = Board::scoreTable[extractCol(grid, c)];
-		score += colScore;
+	if(sEvaluator) {
+		return sEvaluator->evaluate(mCompressedGrid);
 	}
 	
-	return score;
+	return lineScore;
 }
 
 
-void Board::allPlaces(Board* places) const {
-	CompressedGrid grid = mCompressedGrid;
-	for(int shift = MAKE_SHIFT(0, 0); shift <= MAKE_SHIFT(3, 3); shift = MAKE_RIGHT(shift)) {
-		Tile cur = EXTRACT_TILE(grid, shift);
-		if(cur == TILE_EMPTY) {
-			places++->mCompressedGrid = insertingTile(grid, shift, TILE_2);
-			places++->mCompressedGrid = insertingTile(grid, shift, TILE_4);
+void Board::scoreBounds(int* lower, int* upper) {
+	if(sEvaluator) {
+		*lower = INT_MIN;
+		*upper = INT_MAX;
+		return;
+	}
+	
+	// Eight lines of at most 2^23 each can't overflow
+	*lower = std::min(8 * sLowestLineScore, -999999);
+	*upper = std::max(8 * sHighestLineScore, -999999);
+}
+
+
+int Board::lineScore() const {
+	return selectedKernels()->evaluate(mCompressedGrid);
+}
+
+
+int Board::updatedLineScore(int lineScore, Board after) const {
+	CompressedGrid grid = mCompressedGrid, next = after.mCompressedGrid;
+	CompressedGrid diff = grid ^ next;
+	
+	// Swap the scores of just the rows and columns that differ
+	for(unsigned i = 0; i < 4; i++) {
+		if(diff & ((CompressedGrid)0xffff << MAKE_ROW_SHIFT(i))) {
+			lineScore += lineTable[extractRow(next, i)].score() - lineTable[extractRow(grid, i)].score();
 		}
-		else {
-			places++->mCompressedGrid = GRID_EMPTY;
-			places++->mCompressedGrid = GRID_EMPTY;
+		if(diff & (0x000f000f000f000f << MAKE_COL_SHIFT(i))) {
+			lineScore += lineTable[extractCol(next, i)].score() - lineTable[extractCol(grid, i)].score();
 		}
 	}
+	
+	return lineScore;
 }
 
-void Board::allShifts(Board* shifts) const {
-	CompressedGrid grid = mCompressedGrid;
-	shifts->mCompressedGrid = shiftingTilesUp(grid);
-	if(shifts->mCompressedGrid == grid) {
-		shifts->mCompressedGrid = GRID_EMPTY;
+
+void Board::estimateScores(const Board* boards, size_t count, int* scores) {
+	static const size_t kPrefetchDistance = 8;
+	
+	if(sEvaluator) {
+		for(size_t i = 0; i < count; i++) {
+			scores[i] = boards[i].estimateScore();
+		}
+		return;
 	}
 	
-	++shifts;
-	shifts->mCompressedGrid = shiftingTilesDown(grid);
-	if(shifts->mCompressedGrid == grid) {
-		shifts->mCompressedGrid = GRID_EMPTY;
+	for(size_t i = 0; i < count; i++) {
+		if(i + kPrefetchDistance < count) {
+			CompressedGrid ahead = boards[i + kPrefetchDistance].mCompressedGrid;
+			CompressedGrid transposed = transposingGrid(ahead);
+			for(unsigned j = 0; j < 4; j++) {
+				__builtin_prefetch(&lineTable[extractRow(ahead, j)]);
+				__builtin_prefetch(&lineTable[extractRow(transposed, j)]);
+			}
+		}
+		
+		// Columns are the rows of the transposed grid
+		CompressedGrid grid = boards[i].mCompressedGrid;
+		CompressedGrid transposed = transposingGrid(grid);
+		int32_t flags = 0;
+		int score = 0;
+		for(unsigned j = 0; j < 4; j++) {
+			const LineInfo& row = lineTable[extractRow(grid, j)];
+			const LineInfo& col = lineTable[extractRow(transposed, j)];
+			flags |= row.scoreAndFlags | col.scoreAndFlags;
+			score += row.score() + col.score();
+		}
+		scores[i] = (flags & (LineInfo::kMovesLeft | LineInfo::kMovesRight)) ? score : -999999;
+	}
+}
+
+
+uint32_t Board::holeMask() const {
+	return packingNybbleBits(emptyNybbles(mCompressedGrid));
+}
+
+
+Tile Board::maxTile() const {
+	Tile ret = TILE_EMPTY;
+	for(int shift = 0; shift < 64; shift += 4) {
+		ret = std::max(ret, (Tile)((mCompressedGrid >> shift) & 0xf));
 	}
+	return ret;
+}
+
+
+unsigned Board::allPlaces(Board* places) const {
+	CompressedGrid grid = mCompressedGrid;
+	unsigned holeCount = 0;
 	
-	++shifts;
-	shifts->mCompressedGrid = shiftingTilesLeft(grid);
-	if(shifts->mCompressedGrid == grid) {
-		shifts->mCompressedGrid = GRID_EMPTY;
+	// Only visit the actual holes, a 2 and then a 4 in each
+	for(CompressedGrid empty = emptyNybbles(grid); empty; empty &= empty - 1) {
+		int shift = __builtin_ctzll(empty);
+		places++->mCompressedGrid = insertingTile(grid, shift, TILE_2);
+		places++->mCompressedGrid = insertingTile(grid, shift, TILE_4);
+		++holeCount;
 	}
 	
-	++shifts;
-	shifts->mCompressedGrid = shiftingTilesRight(grid);
-	if(shifts->mCompressedGrid == grid) {
-		shifts->mCompressedGrid = GRID_EMPTY;
+	return holeCount;
+}
+
+void Board::allShifts(Board* shifts) const {
+	CompressedGrid grid = mCompressedGrid;
+	CompressedGrid results[4];
+	selectedKernels()->allShifts(grid, results);
+	
+	// Moves that don't change the board are left empty
+	for(int i = 0; i < 4; i++) {
+		shifts[i].mCompressedGrid = (results[i] == grid) ? GRID_EMPTY : results[i];
 	}
 }
 
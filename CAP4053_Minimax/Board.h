@@ -9,7 +9,9 @@
 #ifndef MM_BOARD_H
 #define MM_BOARD_H
 
+#include <cstddef>
 #include <cstdint>
+#include <random>
 #include "Direction.h"
 
 typedef uint64_t CompressedGrid;
@@ -33,35 +35,166 @@ typedef uint_fast8_t Tile;
 #define TILE_16384  ((Tile)14)
 #define TILE_32768  ((Tile)15)
 
+class Evaluator;
 
-class Board {
+
+/**
+ * Weights of the terms in the handcrafted line heuristic behind the Board::lineTable scores.
+ */
+struct HeuristicWeights {
+	int emptyTile = 500;
+	int bigTileOnEdge = 2400;
+	int nearMerge = 80;
+	int monotonic = 1500;
+	
+	/**
+	 * Parse weights written as "emptyTile,bigTileOnEdge,nearMerge,monotonic".
+	 * @return False if the text isn't four comma-separated integers
+	 */
+	bool parse(const char* text);
+};
+
+
+/**
+ * Board of N x N tiles, each stored in Bits bits of a packed grid. The generic version lives in
+ * BasicBoard.h; the classic 4x4 board with 4-bit tiles is fully specialized below as Board so
+ * the game and the 64-bit search keep their hand-tuned code.
+ */
+template<unsigned N, unsigned Bits>
+class BasicBoard;
+
+template<>
+class BasicBoard<4, 4>;
+typedef BasicBoard<4, 4> Board;
+
+
+template<>
+class BasicBoard<4, 4> {
 public:
-	static uint16_t shiftTable[65536];
-	static int scoreTable[65536];
+	typedef CompressedGrid Grid;
+	static const unsigned kSize = 4;
+	static const unsigned kTileBits = 4;
+	
+	/**
+	 * Everything the hot paths need to know about one 16-bit row or column, packed into 8 bytes
+	 * so moving, terminal detection and evaluation all share a single lookup per line. Left is
+	 * toward the low nybble, which is LEFT for rows and UP for columns.
+	 */
+	struct LineInfo {
+		static const int32_t kMovesLeft = 1;
+		static const int32_t kMovesRight = 2;
+		
+		uint16_t left;
+		uint16_t right;
+		
+		// Line score in the upper 24 bits, move flags in the lower 8
+		int32_t scoreAndFlags;
+		
+		int score() const { return scoreAndFlags >> 8; }
+		int32_t flags() const { return scoreAndFlags & 0xff; }
+	};
+	
+	/**
+	 * The line tables start out in static storage. fillShiftTable() moves them to huge pages
+	 * while HugePages is enabled, and back when it isn't, so fill the scores after it.
+	 */
+	static LineInfo* lineTable;
+	static uint32_t* mergeScoreTable;
 	static void fillShiftTable();
-	static void fillScoreTable();
+	static void fillScoreTable(const HeuristicWeights& weights = HeuristicWeights());
+	static uint64_t heuristicVersion();
+	static void setEvaluator(const Evaluator* evaluator);
+	
+	/**
+	 * Name of the ISA variant of the board kernels in use: avx2, bmi2, sse4 or scalar. The
+	 * best one the CPU supports is picked at startup.
+	 */
+	static const char* kernelName();
+	
+	/**
+	 * Switch to another kernel variant, e.g. to benchmark them against each other.
+	 * @return False if the variant is unknown or the CPU doesn't support it
+	 */
+	static bool selectKernels(const char* name);
+	
+	BasicBoard();
+	explicit BasicBoard(CompressedGrid grid);
 	
-	Board();
+	CompressedGrid getCompressedGrid() const;
 	
 	void placeTile(Tile tile, unsigned row, unsigned col);
 	unsigned findHoles(int* holeShifts) const;
+	
+	/**
+	 * Bit row * 4 + col is set for every empty cell.
+	 */
+	uint32_t holeMask() const;
+	
+	/**
+	 * The largest tile on the board, or TILE_EMPTY if there are none.
+	 */
+	Tile maxTile() const;
+	
 	void placeRandom(unsigned* pRow = nullptr, unsigned* pCol = nullptr, Tile* pTile = nullptr);
+	void placeRandom(std::mt19937& rng, unsigned* pRow = nullptr, unsigned* pCol = nullptr, Tile* pTile = nullptr);
 	
 	bool shiftTiles(Direction dir);
 	bool shiftTilesUp();
 	bool shiftTilesDown();
 	bool shiftTilesLeft();
 	bool shiftTilesRight();
+	unsigned shiftScore(Direction dir) const;
 	
 	bool isGameOver() const;
 	void print() const;
 	
 	int estimateScore() const;
-	void allPlaces(Board* places) const;
+	
+	/**
+	 * estimateScore() for a board whose lineScore() is already known.
+	 */
+	int estimateScore(int lineScore) const;
+	
+	/**
+	 * Sum of the lineTable scores of every row and column.
+	 */
+	int lineScore() const;
+	
+	/**
+	 * lineScore() of @p after, given that this board's is @p lineScore. Only the rows and
+	 * columns that differ are looked up, so a placement costs four lookups.
+	 */
+	int updatedLineScore(int lineScore, Board after) const;
+	
+	/**
+	 * estimateScore() of @p count boards at once. The table lines of boards further along are
+	 * prefetched, and each line's entry serves both the game over check and the score.
+	 */
+	static void estimateScores(const Board* boards, size_t count, int* scores);
+	
+	/**
+	 * Bounds on every estimateScore(), including the game over score, for pruning averages.
+	 * With an Evaluator set nothing is known, and the bounds span all of int.
+	 */
+	static void scoreBounds(int* lower, int* upper);
+	
+	/**
+	 * Fill @p places with the board after placing a 2 and then a 4 in each hole, for the holes
+	 * in holeMask() order.
+	 * @return Number of holes, so twice the number of boards written
+	 */
+	unsigned allPlaces(Board* places) const;
+	
 	void allShifts(Board* shifts) const;
 	bool isEmpty() const;
 
 protected:
+	static const Evaluator* sEvaluator;
+	
+	// Lowest and highest lineTable scores, kept by fillScoreTable()
+	static int sLowestLineScore;
+	static int sHighestLineScore;
+	
 	CompressedGrid mCompressedGrid;
 };
 
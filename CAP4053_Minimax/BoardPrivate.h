@@ -10,6 +10,7 @@
 #define MM_BOARDPRIVATE_H
 
 #include <cstdint>
+#include "Board.h"
 
 /*
  * In the compressed grid format, each tile is stored in a nybble in row-major format. That
@@ -31,4 +32,51 @@
 #define GET_TILE(grid, row, col) EXTRACT_TILE(grid, MAKE_SHIFT(row, col))
 #define TILE_VALUE(tile) (1 << (uint_fast32_t)(tile))
 
+
+/**
+ * Zero-nybble detection: the low bit of every empty nybble is set, so bit MAKE_SHIFT(row, col)
+ * marks each hole. Walk the holes with ctz and clear them with (mask & (mask - 1)).
+ */
+static inline CompressedGrid emptyNybbles(CompressedGrid grid) {
+	CompressedGrid x = grid | (grid >> 1);
+	x |= x >> 2;
+	return ~x & 0x1111111111111111;
+}
+
+/**
+ * Pack the low bit of every nybble into bit row * 4 + col of a 16-bit mask.
+ */
+static inline uint16_t packingNybbleBits(CompressedGrid bits) {
+	bits = (bits | (bits >> 3)) & 0x0303030303030303;
+	bits = (bits | (bits >> 6)) & 0x000f000f000f000f;
+	bits = (bits | (bits >> 12)) & 0x000000ff000000ff;
+	return (uint16_t)(bits | (bits >> 24));
+}
+
+/**
+ * Shift of the hole numbered @p index, counting from the lowest set bit of @p empty.
+ */
+static inline int selectingHole(CompressedGrid empty, unsigned index) {
+	while(index--) {
+		empty &= empty - 1;
+	}
+	return __builtin_ctzll(empty);
+}
+
+
+/**
+ * Swap rows and columns, so column operations can reuse the row tables.
+ */
+static inline CompressedGrid transposingGrid(CompressedGrid grid) {
+	// Swap nybbles across the diagonal of each 2x2 block, then swap the off-diagonal blocks
+	CompressedGrid a1 = grid & 0xf0f00f0ff0f00f0f;
+	CompressedGrid a2 = grid & 0x0000f0f00000f0f0;
+	CompressedGrid a3 = grid & 0x0f0f00000f0f0000;
+	CompressedGrid a = a1 | (a2 << 12) | (a3 >> 12);
+	CompressedGrid b1 = a & 0xff00ff0000ff00ff;
+	CompressedGrid b2 = a & 0x00ff00ff00000000;
+	CompressedGrid b3 = a & 0x00000000ff00ff00;
+	return b1 | (b2 >> 24) | (b3 << 24);
+}
+
 #endif /* MM_BOARDPRIVATE_H */
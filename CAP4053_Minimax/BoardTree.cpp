@@ -7,47 +7,150 @@
 //
 
 #include "BoardTree.h"
+#include "BasicBoard.h"
+#include "Trace.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
 #include <iostream>
 
 
-const unsigned BoardTree::kMaximumDepth = 5;
+template<class BoardType>
+const unsigned BasicBoardTree<BoardType>::kMaximumDepth = 5;
 
+template<class BoardType>
+const unsigned BasicBoardTree<BoardType>::kMaximumBudgetDepth = 16;
 
-BoardTree::BoardTree(Board initBoard)
-: mHead(ShiftNode::allocate(initBoard)), mBestMove(Direction::UP) { }
+template<class BoardType>
+const size_t BasicBoardTree<BoardType>::kReclaimSlice = 4096;
 
 
+template<class BoardType>
+BasicBoardTree<BoardType>::BasicBoardTree(BoardType initBoard)
+: mHead(ShiftNodeType::acquire(initBoard)), mBestMove(Direction::UP), mLastScore(0), mLogging(true),
+  mMaximumDepth(kMaximumDepth), mEngine(SearchEngine::TREE), mMode(SearchMode::MINIMAX),
+  mDriver(SearchDriver::ALPHA_BETA), mNodeBudget(0), mMemoryBudget(0),
+  mNodeCount(0), mLastDepth(0), mCreatedNodes(0), mCounting(false) { }
 
-void BoardTree::setBoard(Board newBoard) {
-	mHead->setBoard(newBoard);
+
+template<class BoardType>
+BasicBoardTree<BoardType>::~BasicBoardTree() {
+	// Free the whole tree now, as workers destroy their tree right before their thread exits and
+	// takes the queue of discarded nodes with it. Other trees hold their own references.
+	updateHead(nullptr);
+	reclaim(SIZE_MAX);
+}
+
+
+template<class BoardType>
+void BasicBoardTree<BoardType>::setBoard(BoardType newBoard) {
+	// Picks up whatever subtree this thread already has for the board
+	updateHead(ShiftNodeType::acquire(newBoard));
 }
 
 
-bool BoardTree::isValid() const {
+template<class BoardType>
+bool BasicBoardTree<BoardType>::isValid() const {
 	return mHead != nullptr;
 }
 
 
-Direction BoardTree::getBestMove() {
-	// If there are few holes left on the board, allow going one level deeper
-	int depth = kMaximumDepth;
-	{
-		Board board = mHead->getBoard();
-		int holes[16];
-		unsigned holeCount = board.findHoles(holes);
-		if(holeCount >= 3) {
+template<class BoardType>
+Direction BasicBoardTree<BoardType>::getBestMove() {
+	MM_TRACE_SPAN("BoardTree::getBestMove");
+	std::chrono::steady_clock::time_point moveStart = std::chrono::steady_clock::now();
+	
+	// Free a slice of the discarded nodes. Freeing at least as many as the last search created
+	// keeps the backlog from growing however little time callers give reclaim().
+	reclaim(kReclaimSlice + mCreatedNodes);
+	
+	// Counters only count the thread that opened them, so open them on the searching thread.
+	// They count the search alone, not the freeing around it.
+	if(mCounting && !mCounters) {
+		mCounters = PerfCounters::open();
+		if(!mCounters) {
+			std::cerr << "Performance counters aren't available here" << std::endl;
+			mCounting = false;
+		}
+	}
+	PerfCounters::Sample countStart;
+	if(mCounters) {
+		countStart = mCounters->read();
+	}
+	size_t liveBefore = ShiftNodeType::getLiveCount() + PlaceNodeType::getLiveCount();
+	
+	ShiftNodeType::beginSearch();
+	BoardType board = mHead->getBoard();
+	unsigned holeCount = __builtin_popcount(board.holeMask());
+	int score = INT_MIN;
+	if(mNodeBudget == 0) {
+		// If there are few holes left on the board, allow going one level deeper
+		unsigned depth = mMaximumDepth;
+		if(holeCount >= 3 && depth > 1) {
 			--depth;
 		}
-		if(holeCount >= 12) {
+		if(holeCount >= 12 && depth > 1) {
 			--depth;
 		}
+		
+		SearchBudget budget;
+		score = searchDepth(depth, budget, &mBestMove);
+		mNodeCount = budget.getUsed();
+		mLastDepth = depth;
+	}
+	else {
+		// Deepen one shift at a time until the budget runs out in the middle of an iteration,
+		// then keep the result of the last iteration which finished
+		SearchBudget budget(mNodeBudget);
+		Direction finishedDir = mBestMove;
+		unsigned finishedDepth = 0;
+		for(unsigned depth = 1; depth <= kMaximumBudgetDepth; depth++) {
+			Direction dir = finishedDir;
+			int iterationScore = searchDepth(depth, budget, &dir);
+			if(budget.isExhausted()) {
+				break;
+			}
+			score = iterationScore;
+			finishedDir = dir;
+			finishedDepth = depth;
+		}
+		mNodeCount = budget.getUsed();
+		
+		if(finishedDepth > 0) {
+			mBestMove = finishedDir;
+			mLastDepth = finishedDepth;
+		}
+		else {
+			// A budget too small for even one shift still has to produce a move
+			SearchBudget fallback;
+			score = searchDepth(1, fallback, &mBestMove);
+			mNodeCount += fallback.getUsed();
+			mLastDepth = 1;
+		}
+	}
+	mLastScore = score;
+	
+	// Searching only ever adds nodes
+	mCreatedNodes = ShiftNodeType::getLiveCount() + PlaceNodeType::getLiveCount() - liveBefore;
+	
+	if(mCounters) {
+		mLastCounts = mCounters->read() - countStart;
+	}
+	
+	if(mMemoryBudget) {
+		trimMemory();
 	}
 	
-	// Compute max score
-	int score = mHead->getMaxScore(depth, INT_MIN, INT_MAX, &mBestMove);
+	// Crowded boards are searched deeper, so bucket by how crowded and how far along the game is
+	std::chrono::steady_clock::duration moveTime = std::chrono::steady_clock::now() - moveStart;
+	mLatencies.record(holeCount, board.maxTile(), (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(moveTime).count());
+	
+	if(!mLogging) {
+		return mBestMove;
+	}
 	
 	// Get printable direction for log
-	char cDir;
+	char cDir = '?';
 	switch(mBestMove) {
 		case Direction::UP:
 			cDir = 'U';
@@ -67,15 +170,176 @@ Direction BoardTree::getBestMove() {
 	}
 	
 	// Log results
-	std::cerr << "Picking direction " << cDir << " with score " << score << std::endl;
+	std::cerr << "Picking direction " << cDir << " with score " << score
+	          << " (depth " << mLastDepth << ", " << mNodeCount << " nodes)";
+	char counts[256];
+	if(mCounters && PerfCounters::format(counts, sizeof(counts), mLastCounts, (double)std::max<uint64_t>(mNodeCount, 1), "node")) {
+		std::cerr << " " << counts;
+	}
+	std::cerr << std::endl;
 	return mBestMove;
 }
 
 
-void BoardTree::placedTile(unsigned row, unsigned col, Tile tile) {
-	PlaceNode* firstMove = mHead->getChild(mBestMove);
-	if(firstMove) {
-		updateHead(firstMove->getChild(row, col, tile));
+template<class BoardType>
+int BasicBoardTree<BoardType>::searchDepth(unsigned depth, SearchBudget& budget, Direction* dir) {
+	switch(mEngine) {
+		case SearchEngine::TREE:
+			if(mDriver == SearchDriver::MTDF) {
+				return searchMtdf(depth, budget, dir);
+			}
+			return mHead->getMaxScore(depth, INT_MIN, INT_MAX, budget, mDriver == SearchDriver::PRINCIPAL_VARIATION, dir);
+		
+		case SearchEngine::DEPTH_FIRST:
+			return mDepthFirst.search(mHead->getBoard(), depth, mMode, budget, dir);
+		
+		case SearchEngine::FRONTIER:
+			return mFrontier.search(mHead->getBoard(), depth, mMode, budget, dir);
+	}
+	
+	// Only reachable if mEngine holds none of the engines, and then there's no score to give
+	return INT_MIN;
+}
+
+
+template<class BoardType>
+int BasicBoardTree<BoardType>::searchMtdf(unsigned depth, SearchBudget& budget, Direction* dir) {
+	// Each probe either raises the lower bound or lowers the upper bound on the score, until they
+	// meet. The first guess is the last move's score, which is usually close.
+	int guess = mLastScore;
+	int lower = INT_MIN, upper = INT_MAX;
+	Direction bestDir = *dir, probeDir = *dir;
+	bool proven = false;
+	while(lower < upper) {
+		int beta = (guess == lower) ? guess + 1 : guess;
+		guess = mHead->getMaxScore(depth, beta - 1, beta, budget, false, &probeDir);
+		if(budget.isExhausted()) {
+			break;
+		}
+		
+		if(guess < beta) {
+			upper = guess;
+		}
+		else {
+			// Only a probe that failed high proves its move reaches the score
+			lower = guess;
+			bestDir = probeDir;
+			proven = true;
+		}
+	}
+	
+	// When every probe failed low no move was proven, but the root still picked a legal one
+	*dir = proven ? bestDir : probeDir;
+	return guess;
+}
+
+
+template<class BoardType>
+void BasicBoardTree<BoardType>::trimMemory() {
+	// The tables of live nodes count too, as they stay as big as the biggest tree until shrunk
+	auto liveBytes = [] {
+		return ShiftNodeType::getLiveCount() * sizeof(ShiftNodeType) + PlaceNodeType::getLiveCount() * sizeof(PlaceNodeType) +
+			ShiftNodeType::getTableBytes() + PlaceNodeType::getTableBytes();
+	};
+	auto freeing = [this] {
+		reclaim(SIZE_MAX);
+		ShiftNodeType::shrinkTable();
+		PlaceNodeType::shrinkTable();
+	};
+	
+	// Collapse whatever went unsearched for 32 searches, then 16 and so on, down to everything
+	// the last search didn't touch and finally the whole tree below the head. The budget is a
+	// hard limit, so the collapsed subtrees are freed right away rather than a slice at a time.
+	uint32_t now = ShiftNodeType::getSearchStamp();
+	freeing();
+	for(uint32_t age = 32; age > 0 && liveBytes() > mMemoryBudget; age /= 2) {
+		ShiftNodeType::collapseBefore(now > age ? now - age + 1 : 0);
+		freeing();
+	}
+	if(mHead && liveBytes() > mMemoryBudget) {
+		mHead->releaseChildren();
+		freeing();
+	}
+	
+	// Keep the pooled nodes that still fit in the budget, place nodes first, and free the rest
+	size_t spare = (liveBytes() < mMemoryBudget) ? mMemoryBudget - liveBytes() : 0;
+	size_t placeBytes = std::min(spare, (PlaceNodeType::getAllocatedCount() - PlaceNodeType::getLiveCount()) * sizeof(PlaceNodeType));
+	PlaceNodeType::trimPool(placeBytes / sizeof(PlaceNodeType));
+	ShiftNodeType::trimPool((spare - placeBytes) / sizeof(ShiftNodeType));
+}
+
+
+template<class BoardType>
+bool BasicBoardTree<BoardType>::reclaim(size_t nodes) {
+	MM_TRACE_SPAN("BoardTree::reclaim");
+	
+	// Freeing a node of one type queues children of the other, so alternate until neither
+	// has anything left or the slice is used up
+	while(nodes > 0) {
+		size_t freed = ShiftNodeType::reclaim(nodes);
+		freed += PlaceNodeType::reclaim(nodes - freed);
+		if(freed == 0) {
+			break;
+		}
+		nodes -= freed;
+	}
+	return ShiftNodeType::getDeadCount() + PlaceNodeType::getDeadCount() != 0;
+}
+
+
+template<class BoardType>
+size_t BasicBoardTree<BoardType>::getNodeBytes() {
+	return ShiftNodeType::getAllocatedCount() * sizeof(ShiftNodeType) + PlaceNodeType::getAllocatedCount() * sizeof(PlaceNodeType) +
+		ShiftNodeType::getTableBytes() + PlaceNodeType::getTableBytes();
+}
+
+
+template<class BoardType>
+size_t BasicBoardTree<BoardType>::getHighWaterBytes() {
+	// The pools and tables peak at different times, so this slightly overstates the real peak
+	return ShiftNodeType::getHighWaterCount() * sizeof(ShiftNodeType) + PlaceNodeType::getHighWaterCount() * sizeof(PlaceNodeType) +
+		ShiftNodeType::getHighWaterTableBytes() + PlaceNodeType::getHighWaterTableBytes();
+}
+
+
+template<class BoardType>
+int BasicBoardTree<BoardType>::getLastScore() const {
+	return mLastScore;
+}
+
+
+template<class BoardType>
+uint64_t BasicBoardTree<BoardType>::getNodeCount() const {
+	return mNodeCount;
+}
+
+
+template<class BoardType>
+unsigned BasicBoardTree<BoardType>::getLastDepth() const {
+	return mLastDepth;
+}
+
+
+template<class BoardType>
+void BasicBoardTree<BoardType>::placedTile(unsigned row, unsigned col, Tile tile) {
+	// Without a tree, just play the move on the head's board
+	if(mEngine != SearchEngine::TREE) {
+		BoardType board = mHead->getBoard();
+		if(board.shiftTiles(mBestMove)) {
+			board.placeTile(tile, row, col);
+			updateHead(ShiftNodeType::acquire(board));
+		}
+		else {
+			updateHead(nullptr);
+		}
+		return;
+	}
+	
+	PlaceNodeType* firstMove = mHead->getChild(mBestMove);
+	ShiftNodeType* newHead = firstMove ? firstMove->getChild(row, col, tile) : nullptr;
+	if(newHead) {
+		newHead->retain();
+		updateHead(newHead);
 	}
 	else {
 		updateHead(nullptr);
@@ -83,8 +347,89 @@ void BoardTree::placedTile(unsigned row, unsigned col, Tile tile) {
 }
 
 
-void BoardTree::updateHead(ShiftNode* newHead) {
-	mHead->prune(newHead);
-	mHead->deallocate();
+template<class BoardType>
+void BasicBoardTree<BoardType>::setLogging(bool enabled) {
+	mLogging = enabled;
+}
+
+
+template<class BoardType>
+void BasicBoardTree<BoardType>::setMaximumDepth(unsigned depth) {
+	// A depth of zero would never look at a move
+	mMaximumDepth = depth ? depth : 1;
+}
+
+
+template<class BoardType>
+void BasicBoardTree<BoardType>::setSearchEngine(SearchEngine engine) {
+	// Only the tree engine looks at the head's children, so drop them
+	if(engine != SearchEngine::TREE && mHead) {
+		mHead->releaseChildren();
+	}
+	mEngine = engine;
+}
+
+
+template<class BoardType>
+void BasicBoardTree<BoardType>::setSearchMode(SearchMode mode) {
+	mMode = mode;
+}
+
+
+template<class BoardType>
+void BasicBoardTree<BoardType>::setSearchDriver(SearchDriver driver) {
+	mDriver = driver;
+	mDepthFirst.setNullWindows(driver == SearchDriver::PRINCIPAL_VARIATION);
+}
+
+
+template<class BoardType>
+void BasicBoardTree<BoardType>::setNodeBudget(uint64_t nodes) {
+	mNodeBudget = nodes;
+}
+
+
+template<class BoardType>
+void BasicBoardTree<BoardType>::setMemoryBudget(size_t bytes) {
+	mMemoryBudget = bytes;
+}
+
+
+template<class BoardType>
+void BasicBoardTree<BoardType>::setCounting(bool enabled) {
+	mCounting = enabled;
+	if(!enabled) {
+		mCounters.reset();
+		mLastCounts = PerfCounters::Sample();
+	}
+}
+
+
+template<class BoardType>
+PerfCounters::Sample BasicBoardTree<BoardType>::getLastCounts() const {
+	return mLastCounts;
+}
+
+
+template<class BoardType>
+const MoveLatencies& BasicBoardTree<BoardType>::getLatencies() const {
+	return mLatencies;
+}
+
+
+template<class BoardType>
+void BasicBoardTree<BoardType>::updateHead(ShiftNodeType* newHead) {
+	MM_TRACE_SPAN("BoardTree::updateHead");
+	
+	// The new head's reference already keeps its subtree alive, so releasing the old head only
+	// discards the nodes nothing else reaches, and those are freed later by reclaim()
+	if(mHead) {
+		mHead->release();
+	}
 	mHead = newHead;
 }
+
+
+template class BasicBoardTree<Board>;
+template class BasicBoardTree<BasicBoard<4, 5>>;
+template class BasicBoardTree<BasicBoard<5, 4>>;
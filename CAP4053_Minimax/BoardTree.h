@@ -15,24 +15,152 @@
 #include "Direction.h"
 #include "ShiftNode.h"
 #include "PlaceNode.h"
+#include "DepthFirstSearch.h"
+#include "FrontierSearch.h"
+#include "LatencyHistogram.h"
+#include "PerfCounters.h"
+#include "SearchBudget.h"
+#include "SearchMode.h"
 
-class BoardTree {
+/**
+ * How BoardTree searches. TREE keeps the ShiftNode/PlaceNode tree and reuses the subtree of the
+ * actual move on the next search. DEPTH_FIRST searches without allocating any nodes. FRONTIER
+ * expands whole levels at once without pruning. DEPTH_FIRST and FRONTIER also search EXPECTIMAX,
+ * with the same results; TREE always searches MINIMAX.
+ */
+enum class SearchEngine: uint_fast8_t {
+	TREE, DEPTH_FIRST, FRONTIER
+};
+
+/**
+ * How the TREE engine drives its alpha-beta search. PRINCIPAL_VARIATION searches every move after
+ * the first with a null window and only re-searches the ones that beat it. MTDF converges on the
+ * score with zero-window probes from the root, starting at the last move's score. Both revisit
+ * nodes many times and lean on the bounds each node keeps. The depth-first engine takes
+ * PRINCIPAL_VARIATION as null windows for its EXPECTIMAX searches, which Star2 needs to cut
+ * anything, and otherwise the other engines ignore the driver.
+ */
+enum class SearchDriver: uint_fast8_t {
+	ALPHA_BETA, PRINCIPAL_VARIATION, MTDF
+};
+
+template<class BoardType>
+class BasicBoardTree {
 public:
-	BoardTree(Board initBoard);
+	typedef BasicShiftNode<BoardType> ShiftNodeType;
+	typedef BasicPlaceNode<BoardType> PlaceNodeType;
 	
-	void setBoard(Board newBoard);
+	BasicBoardTree(BoardType initBoard);
+	~BasicBoardTree();
+	
+	void setBoard(BoardType newBoard);
 	bool isValid() const;
 	void populateTree();
 	Direction getBestMove();
+	int getLastScore() const;
+	
+	/**
+	 * Nodes the last getBestMove() visited, for sizing searches in CPU cost per move.
+	 */
+	uint64_t getNodeCount() const;
+	
+	/**
+	 * Depth of the search whose move the last getBestMove() returned.
+	 */
+	unsigned getLastDepth() const;
+	
 	void placedTile(unsigned row, unsigned col, Tile tile);
+	void setLogging(bool enabled);
+	void setMaximumDepth(unsigned depth);
+	void setSearchEngine(SearchEngine engine);
+	void setSearchMode(SearchMode mode);
+	void setSearchDriver(SearchDriver driver);
+	
+	/**
+	 * Limit searches by node count instead of depth. Each getBestMove() then deepens one shift at
+	 * a time and returns the move of the deepest search that finished within @p nodes. Zero, the
+	 * default, searches to the maximum depth instead.
+	 */
+	void setNodeBudget(uint64_t nodes);
+	
+	/**
+	 * Cap the memory of the tree nodes, alive or pooled, and the tables sharing them that this
+	 * thread keeps between searches. After each getBestMove() the subtrees searched longest ago
+	 * are collapsed back to leaves until the live nodes and their tables fit in @p bytes, and
+	 * pooled nodes beyond that are freed. Zero,
+	 * the default, keeps everything. Nodes in HugePages' arena can't be freed, so with huge pages
+	 * only the live nodes are capped.
+	 */
+	void setMemoryBudget(size_t bytes);
+	
+	/**
+	 * Count the hardware events of every getBestMove(), on the thread calling it, and log them
+	 * per node with the move. Where perf_event_open isn't allowed this is a no-op, and where only
+	 * the hardware events aren't, CPU time is counted instead. See PerfCounters.
+	 */
+	void setCounting(bool enabled);
+	
+	/**
+	 * Events the last getBestMove() counted, all of them uncounted unless counting is on.
+	 */
+	PerfCounters::Sample getLastCounts() const;
+	
+	/**
+	 * How long every getBestMove() so far took, reclaiming and trimming included, by the empty
+	 * cells and largest tile of the board it searched.
+	 */
+	const MoveLatencies& getLatencies() const;
+	
+	/**
+	 * Bytes of tree nodes this thread has allocated, alive or pooled, and of their tables, now
+	 * and at most.
+	 */
+	static size_t getNodeBytes();
+	static size_t getHighWaterBytes();
+	
+	/**
+	 * Free up to @p nodes of the nodes that moves and collapses have discarded on this thread.
+	 * Discarded subtrees aren't torn down when they're dropped but a slice at a time, partly at
+	 * the start of each getBestMove() and partly here, for callers with time to spare between
+	 * searches.
+	 * @return True if discarded nodes are still waiting
+	 */
+	static bool reclaim(size_t nodes);
 
 private:
-	void updateHead(ShiftNode* newHead);
+	/**
+	 * Move the head to @p newHead, taking over a reference the caller holds on it.
+	 */
+	void updateHead(ShiftNodeType* newHead);
+	int searchDepth(unsigned depth, SearchBudget& budget, Direction* dir);
+	int searchMtdf(unsigned depth, SearchBudget& budget, Direction* dir);
+	void trimMemory();
 	
 	static const unsigned kMaximumDepth;
+	static const unsigned kMaximumBudgetDepth;
+	static const size_t kReclaimSlice;
 	
-	ShiftNode* mHead;
+	ShiftNodeType* mHead;
 	Direction mBestMove;
+	int mLastScore;
+	bool mLogging;
+	unsigned mMaximumDepth;
+	SearchEngine mEngine;
+	SearchMode mMode;
+	SearchDriver mDriver;
+	BasicDepthFirstSearch<BoardType> mDepthFirst;
+	BasicFrontierSearch<BoardType> mFrontier;
+	uint64_t mNodeBudget;
+	size_t mMemoryBudget;
+	uint64_t mNodeCount;
+	unsigned mLastDepth;
+	size_t mCreatedNodes;
+	bool mCounting;
+	std::unique_ptr<PerfCounters> mCounters;
+	PerfCounters::Sample mLastCounts;
+	MoveLatencies mLatencies;
 };
 
+typedef BasicBoardTree<Board> BoardTree;
+
 #endif /* MM_BOARDTREE_H */
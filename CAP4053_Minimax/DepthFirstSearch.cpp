@@ -0,0 +1,319 @@
+//
+//  DepthFirstSearch.cpp
+//  CAP4053_Minimax
+//
+//  Created by kTeam on 10/19/26.
+//  Copyright © 2026 kTeam. All rights reserved.
+//
+
+#include "DepthFirstSearch.h"
+#include "BasicBoard.h"
+#include "ScoreCache.h"
+#include "ShiftNode.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+
+// Each hole is equally likely, then a 2 with 90% and a 4 with 10% probability. allPlaces()
+// writes the 2 and the 4 of each hole next to each other.
+static inline double placementOdds(unsigned i) {
+	return (i % 2 == 0) ? 0.9 : 0.1;
+}
+
+// One past the possible scores is as good as infinity for a window, and still fits in an int
+static inline int windowBound(double bound, int lowest, int highest) {
+	double low = std::max((double)lowest - 1, (double)INT_MIN);
+	double high = std::min((double)highest + 1, (double)INT_MAX);
+	return (int)std::max(low, std::min(bound, high));
+}
+
+
+template<class BoardType>
+BasicDepthFirstSearch<BoardType>::BasicDepthFirstSearch()
+: mNullWindows(false), mMode(SearchMode::MINIMAX), mLowestScore(INT_MIN), mHighestScore(INT_MAX), mStats() { }
+
+
+template<class BoardType>
+void BasicDepthFirstSearch<BoardType>::setNullWindows(bool enabled) {
+	mNullWindows = enabled;
+}
+
+
+template<class BoardType>
+int BasicDepthFirstSearch<BoardType>::search(BoardType board, unsigned depth, SearchMode mode, SearchBudget& budget, Direction* dir) {
+	if(mPlies.size() <= depth) {
+		mPlies.resize(depth + 1);
+	}
+	mMode = mode;
+	BoardType::scoreBounds(&mLowestScore, &mHighestScore);
+	
+	if(!budget.spending()) {
+		return 0;
+	}
+	
+	int lineScore = board.lineScore();
+	if(depth == 0) {
+		return board.estimateScore(lineScore);
+	}
+	
+	BoardType* shifts = mPlies[depth].shifts;
+	board.allShifts(shifts);
+	
+	int score, maxScore = INT_MIN, alpha = INT_MIN;
+	int firstDir = -1, maxDir = -1;
+	for(int i = 0; i < 4; i++) {
+		if(shifts[i].isEmpty()) {
+			continue;
+		}
+		if(firstDir < 0) {
+			firstDir = i;
+		}
+		
+		int shiftScore = board.updatedLineScore(lineScore, shifts[i]);
+		if(mMode == SearchMode::EXPECTIMAX) {
+			score = scoreAverage(shifts[i], shiftScore, depth - 1, alpha, INT_MAX, i != firstDir, budget);
+		}
+		else {
+			score = getMinScore(shifts[i], shiftScore, depth - 1, alpha, INT_MAX, budget);
+		}
+		if(score > maxScore) {
+			maxScore = score;
+			maxDir = i;
+		}
+		if(maxScore > alpha) {
+			alpha = maxScore;
+		}
+	}
+	
+	// All directions score as INT_MIN, so just pick any one which is legal
+	if(maxDir < 0) {
+		maxDir = firstDir;
+	}
+	
+	// An average needs the real game over score, as in the frontier engine
+	if(maxScore == INT_MIN && mMode == SearchMode::EXPECTIMAX) {
+		maxScore = board.estimateScore(lineScore);
+	}
+	
+	if(dir && maxDir >= 0) {
+		*dir = (Direction)maxDir;
+	}
+	return maxScore;
+}
+
+
+template<class BoardType>
+int BasicDepthFirstSearch<BoardType>::getMaxScore(BoardType board, int lineScore, unsigned depth, int alpha, int beta, SearchBudget& budget) {
+	if(!budget.spending()) {
+		return 0;
+	}
+	
+	if(depth == 0) {
+		return board.estimateScore(lineScore);
+	}
+	
+	int score, maxScore = INT_MIN;
+	int origAlpha = alpha;
+	
+	// The cache only holds minimax scores
+	bool averaging = (mMode == SearchMode::EXPECTIMAX);
+	ScoreCache* cache = averaging ? nullptr : BasicShiftNode<BoardType>::getScoreCache();
+	if(probingCache(cache, board, depth, alpha, beta, &score)) {
+		return score;
+	}
+	
+	BoardType* shifts = mPlies[depth].shifts;
+	board.allShifts(shifts);
+	
+	bool first = true;
+	for(int i = 0; i < 4; i++) {
+		if(shifts[i].isEmpty()) {
+			continue;
+		}
+		
+		int shiftScore = board.updatedLineScore(lineScore, shifts[i]);
+		if(averaging) {
+			score = scoreAverage(shifts[i], shiftScore, depth - 1, alpha, beta, !first, budget);
+			first = false;
+		}
+		else {
+			score = getMinScore(shifts[i], shiftScore, depth - 1, alpha, beta, budget);
+		}
+		if(score > maxScore) {
+			maxScore = score;
+		}
+		if(maxScore > alpha) {
+			alpha = maxScore;
+		}
+		if(alpha >= beta) {
+			break;
+		}
+	}
+	
+	if(maxScore == INT_MIN && averaging) {
+		maxScore = board.estimateScore(lineScore);
+	}
+	
+	if(!budget.isExhausted()) {
+		storingCache(cache, board, depth, origAlpha, beta, maxScore);
+	}
+	return maxScore;
+}
+
+
+template<class BoardType>
+int BasicDepthFirstSearch<BoardType>::getMinScore(BoardType board, int lineScore, unsigned depth, int alpha, int beta, SearchBudget& budget) {
+	if(!budget.spending()) {
+		return 0;
+	}
+	
+	if(depth == 0) {
+		return board.estimateScore(lineScore);
+	}
+	
+	BoardType* places = mPlies[depth].places;
+	unsigned count = 2 * board.allPlaces(places);
+	
+	int score, minScore = INT_MAX;
+	for(unsigned i = 0; i < count; i++) {
+		// Intentionally not decrementing depth here
+		score = getMaxScore(places[i], board.updatedLineScore(lineScore, places[i]), depth, alpha, beta, budget);
+		if(score < minScore) {
+			minScore = score;
+		}
+		if(minScore < beta) {
+			beta = minScore;
+		}
+		if(alpha >= beta) {
+			break;
+		}
+	}
+	
+	return minScore;
+}
+
+
+template<class BoardType>
+int BasicDepthFirstSearch<BoardType>::getAverageScore(BoardType board, int lineScore, unsigned depth, int alpha, int beta, SearchBudget& budget) {
+	if(!budget.spending()) {
+		return 0;
+	}
+	
+	if(depth == 0) {
+		return board.estimateScore(lineScore);
+	}
+	
+	Ply& ply = mPlies[depth];
+	unsigned holes = board.allPlaces(ply.places);
+	unsigned count = 2 * holes;
+	mStats.placements += count;
+	
+	// Star2: the first move after each placement gives a lower bound on its score, and those
+	// alone may lift the average to beta before any placement is searched in full. Probing
+	// costs a search of each first move, so skip it when beta is out of reach anyway, as it is
+	// everywhere but under the null windows.
+	double lowerSum = 0, rest = 1;
+	bool probing = (beta <= mHighestScore);
+	for(unsigned i = 0; i < count; i++) {
+		if(!probing) {
+			ply.lowerBounds[i] = mLowestScore;
+			lowerSum += placementOdds(i) * mLowestScore / holes;
+			continue;
+		}
+		
+		double weight = placementOdds(i) / holes;
+		rest = std::max(rest - weight, 0.0);
+		int probeAlpha = windowBound(floor((alpha - lowerSum - rest * mHighestScore) / weight), mLowestScore, mHighestScore);
+		int probeBeta = windowBound(ceil((beta - lowerSum - rest * mLowestScore) / weight), mLowestScore, mHighestScore);
+		
+		int score = probingMove(ply.places[i], board.updatedLineScore(lineScore, ply.places[i]), depth, probeAlpha, probeBeta, budget);
+		ply.lowerBounds[i] = (score > probeAlpha) ? score : mLowestScore;
+		lowerSum += placementOdds(i) * ply.lowerBounds[i] / holes;
+		
+		if(score >= probeBeta) {
+			int bound = (int)lround(lowerSum + rest * mLowestScore);
+			if(bound >= beta) {
+				mStats.star2Pruned += count;
+				return bound;
+			}
+		}
+	}
+	
+	// Star1: search each placement with the window outside which the average is sure to miss
+	// this node's window, given the bounds on the placements after it. The sum is built in the
+	// same order as the frontier engine's, so both round to the same score.
+	double sum = 0, lowerRest = lowerSum;
+	rest = 1;
+	for(unsigned i = 0; i < count; i++) {
+		double weight = placementOdds(i) / holes;
+		double lowerTerm = placementOdds(i) * ply.lowerBounds[i] / holes;
+		rest = std::max(rest - weight, 0.0);
+		lowerRest -= lowerTerm;
+		
+		int upperBound = (int)lround(sum + (weight + rest) * mHighestScore);
+		int lowerBound = (int)lround(sum + lowerTerm + lowerRest);
+		if(upperBound <= alpha || lowerBound >= beta) {
+			mStats.star1Pruned += count - i;
+			return upperBound <= alpha ? upperBound : lowerBound;
+		}
+		
+		int childAlpha = windowBound(floor((alpha - sum - rest * mHighestScore) / weight), mLowestScore, mHighestScore);
+		int childBeta = windowBound(ceil((beta - sum - lowerRest) / weight), mLowestScore, mHighestScore);
+		int score = getMaxScore(ply.places[i], board.updatedLineScore(lineScore, ply.places[i]), depth, childAlpha, childBeta, budget);
+		sum += placementOdds(i) * score / holes;
+	}
+	
+	return (int)lround(sum);
+}
+
+
+template<class BoardType>
+int BasicDepthFirstSearch<BoardType>::scoreAverage(BoardType board, int lineScore, unsigned depth, int alpha, int beta, bool later, SearchBudget& budget) {
+	if(!mNullWindows || !later) {
+		return getAverageScore(board, lineScore, depth, alpha, beta, budget);
+	}
+	
+	// First try to show this move is no better than alpha, which also gives Star2 a beta within
+	// reach, and only pay for the full window when it is better
+	int score = getAverageScore(board, lineScore, depth, alpha, alpha + 1, budget);
+	if(score > alpha && score < beta) {
+		score = getAverageScore(board, lineScore, depth, alpha, beta, budget);
+	}
+	return score;
+}
+
+
+template<class BoardType>
+int BasicDepthFirstSearch<BoardType>::probingMove(BoardType board, int lineScore, unsigned depth, int alpha, int beta, SearchBudget& budget) {
+	if(!budget.spending()) {
+		return 0;
+	}
+	
+	// The first legal move only bounds the score from below, unless there is no move at all
+	BoardType* shifts = mPlies[depth].shifts;
+	board.allShifts(shifts);
+	for(int i = 0; i < 4; i++) {
+		if(!shifts[i].isEmpty()) {
+			return getAverageScore(shifts[i], board.updatedLineScore(lineScore, shifts[i]), depth - 1, alpha, beta, budget);
+		}
+	}
+	return board.estimateScore(lineScore);
+}
+
+
+template<class BoardType>
+const typename BasicDepthFirstSearch<BoardType>::PruningStats& BasicDepthFirstSearch<BoardType>::getPruningStats() const {
+	return mStats;
+}
+
+
+template<class BoardType>
+void BasicDepthFirstSearch<BoardType>::resetPruningStats() {
+	mStats = PruningStats();
+}
+
+
+template class BasicDepthFirstSearch<Board>;
+template class BasicDepthFirstSearch<BasicBoard<4, 5>>;
+template class BasicDepthFirstSearch<BasicBoard<5, 4>>;
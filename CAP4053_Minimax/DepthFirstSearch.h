@@ -0,0 +1,103 @@
+//
+//  DepthFirstSearch.h
+//  CAP4053_Minimax
+//
+//  Created by kTeam on 10/19/26.
+//  Copyright © 2026 kTeam. All rights reserved.
+//
+
+#ifndef MM_DEPTHFIRSTSEARCH_H
+#define MM_DEPTHFIRSTSEARCH_H
+
+#include <vector>
+#include "Board.h"
+#include "Direction.h"
+#include "SearchBudget.h"
+#include "SearchMode.h"
+
+/**
+ * Minimax search that recurses directly on board values instead of building ShiftNode and
+ * PlaceNode trees. Nothing is kept between searches, so there is no subtree to reuse after a
+ * move, but there is also no node allocation and no pointer chasing. Children are generated
+ * into per-ply buffers that are sized once and reused by every search.
+ *
+ * Visits moves in the same order and cuts off in the same places as the tree, so both find
+ * the same move with the same score.
+ *
+ * In EXPECTIMAX mode placements are averaged like the frontier engine does, and the averages
+ * are pruned with Star1 and Star2 using the bounds of BoardType::scoreBounds(), so the result
+ * is still that of the full-width search. Star2 only cuts below a beta it can reach, which the
+ * open window of a root search never gives it, so it only runs with null windows enabled.
+ */
+template<class BoardType>
+class BasicDepthFirstSearch {
+public:
+	static const unsigned kCellCount = BoardType::kSize * BoardType::kSize;
+	
+	BasicDepthFirstSearch();
+	
+	/**
+	 * Search @p board to @p depth shifts.
+	 * @param budget Charged one node per board visited. The result is meaningless once it's
+	 *               exhausted
+	 * @param dir Receives the best move, or any legal move if they all lose
+	 * @return Score of the best move
+	 */
+	int search(BoardType board, unsigned depth, SearchMode mode, SearchBudget& budget, Direction* dir);
+	
+	/**
+	 * Search every move of an EXPECTIMAX search but the first of each node with a null window
+	 * first, principal variation style, and the full window only when it beats the best so far.
+	 * Off by default: with the game over score in the bounds, the re-searches and Star2's probes
+	 * usually cost more than they prune. MINIMAX searches ignore this.
+	 */
+	void setNullWindows(bool enabled);
+	
+	/**
+	 * Placements of expectimax searches, and how many of them Star1 and Star2 proved irrelevant
+	 * without a full search. Accumulates over searches until reset.
+	 */
+	struct PruningStats {
+		uint64_t placements;
+		uint64_t star1Pruned;
+		uint64_t star2Pruned;
+	};
+	
+	const PruningStats& getPruningStats() const;
+	void resetPruningStats();
+
+private:
+	struct Ply {
+		BoardType shifts[4];
+		BoardType places[kCellCount * 2];
+		int lowerBounds[kCellCount * 2];
+	};
+	
+	int getMaxScore(BoardType board, int lineScore, unsigned depth, int alpha, int beta, SearchBudget& budget);
+	int getMinScore(BoardType board, int lineScore, unsigned depth, int alpha, int beta, SearchBudget& budget);
+	int getAverageScore(BoardType board, int lineScore, unsigned depth, int alpha, int beta, SearchBudget& budget);
+	
+	/**
+	 * getAverageScore() of a move, trying a null window first if null windows are enabled and
+	 * @p later, which is true for every move but the first of a node.
+	 */
+	int scoreAverage(BoardType board, int lineScore, unsigned depth, int alpha, int beta, bool later, SearchBudget& budget);
+	
+	int probingMove(BoardType board, int lineScore, unsigned depth, int alpha, int beta, SearchBudget& budget);
+	
+	// Indexed by the number of shifts left to search, so each depth has its own buffers
+	std::vector<Ply> mPlies;
+	
+	bool mNullWindows;
+	
+	// Set up by each search
+	SearchMode mMode;
+	int mLowestScore;
+	int mHighestScore;
+	
+	PruningStats mStats;
+};
+
+typedef BasicDepthFirstSearch<Board> DepthFirstSearch;
+
+#endif /* MM_DEPTHFIRSTSEARCH_H */
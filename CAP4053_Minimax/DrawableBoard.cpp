@@ -11,6 +11,7 @@
 #include <cstdlib>
 #include "Engine/helpers.h"
 #include "BoardPrivate.h"
+#include "Trace.h"
 
 #define GAME_OVER  (1 << 0)
 #define GAME_DIRTY (1 << 1)
@@ -176,6 +177,8 @@ void DrawableBoard::tryAgain() {
 
 
 void DrawableBoard::draw(sf::RenderTarget& canvas) {
+	MM_TRACE_SPAN("DrawableBoard::draw");
+	
 	// Draw the background grid
 	canvas.draw(mSprBoard);
 	
@@ -6,6 +6,7 @@
 //
 
 #include "GameEngine.h"
+#include "Trace.h"
 
 
 GameEngine::GameEngine(const std::string& windowTitle, unsigned width, unsigned height)
@@ -20,6 +21,8 @@ int GameEngine::run() {
 	sf::Clock timer;
 	
 	while(mWindow.isOpen()) {
+		MM_TRACE_SPAN("GameEngine::frame");
+		
 		sf::Event event;
 		if(mWindow.pollEvent(event)) {
 			switch(event.type) {
@@ -62,10 +65,20 @@ int GameEngine::run() {
 		}
 		
 		float deltaTime = timer.restart().asSeconds();
-		mLevel.update(deltaTime);
-		mLevel.draw(deltaTime);
+		{
+			MM_TRACE_SPAN("GameEngine::update");
+			mLevel.update(deltaTime);
+		}
+		{
+			MM_TRACE_SPAN("GameEngine::draw");
+			mLevel.draw(deltaTime);
+		}
 		
-		mWindow.display();
+		// Waits for vertical sync, so a long display is an idle frame rather than a slow one
+		{
+			MM_TRACE_SPAN("GameEngine::display");
+			mWindow.display();
+		}
 		mWindow.clear({250, 248, 240});
 	}
 	
@@ -0,0 +1,37 @@
+//
+//  Evaluator.h
+//  CAP4053_Minimax
+//
+//  Created by kTeam on 10/19/26.
+//  Copyright © 2026 kTeam. All rights reserved.
+//
+
+#ifndef MM_EVALUATOR_H
+#define MM_EVALUATOR_H
+
+#include <cstdint>
+#include "Board.h"
+
+
+/**
+ * Scores leaf positions for the search. When no evaluator is installed with
+ * Board::setEvaluator(), Board::estimateScore() uses the built-in lineTable heuristic.
+ */
+class Evaluator {
+public:
+	virtual ~Evaluator() { }
+	
+	/**
+	 * Estimate how good a position is for the player. Only called for positions where
+	 * the game isn't over yet.
+	 */
+	virtual int evaluate(CompressedGrid grid) const = 0;
+	
+	/**
+	 * Identify the evaluator and its parameters, so that cached scores computed with a
+	 * different evaluator can be detected. See Board::heuristicVersion().
+	 */
+	virtual uint64_t version() const = 0;
+};
+
+#endif /* MM_EVALUATOR_H */
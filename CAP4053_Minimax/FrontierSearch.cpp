@@ -0,0 +1,224 @@
+//
+//  FrontierSearch.cpp
+//  CAP4053_Minimax
+//
+//  Created by kTeam on 10/19/26.
+//  Copyright © 2026 kTeam. All rights reserved.
+//
+
+#include "FrontierSearch.h"
+#include "BasicBoard.h"
+#include <climits>
+#include <cmath>
+
+
+template<class BoardType>
+void BasicFrontierSearch<BoardType>::Level::clear() {
+	boards.clear();
+	parents.clear();
+	scores.clear();
+}
+
+
+template<class BoardType>
+size_t BasicFrontierSearch<BoardType>::Level::size() const {
+	return boards.size();
+}
+
+
+template<class BoardType>
+BasicFrontierSearch<BoardType>::BasicFrontierSearch()
+: mLastDepth(0) { }
+
+
+template<class BoardType>
+int BasicFrontierSearch<BoardType>::search(BoardType board, unsigned depth, SearchMode mode, SearchBudget& budget, Direction* dir) {
+	// Levels alternate shifts and placements, and the leaves are the boards after the last shift
+	unsigned levelCount = depth ? 2 * depth : 1;
+	if(mLevels.size() < levelCount) {
+		mLevels.resize(levelCount);
+	}
+	
+	Level& root = mLevels[0];
+	root.clear();
+	mLastDepth = 0;
+	root.boards.push_back(board);
+	if(!budget.spending()) {
+		return 0;
+	}
+	
+	// Expand level by level until the requested depth or the size limit
+	unsigned last = 0;
+	while(last + 1 < levelCount) {
+		Level& from = mLevels[last];
+		Level& to = mLevels[last + 1];
+		bool expanded = (last % 2 == 0) ? expandShifts(from, to) : expandPlaces(from, to);
+		if(!expanded) {
+			break;
+		}
+		if(!budget.spending(to.size())) {
+			return 0;
+		}
+		++last;
+	}
+	mLastDepth = (last + 1) / 2;
+	
+	// Score the whole frontier in one batch
+	Level& leaves = mLevels[last];
+	leaves.scores.resize(leaves.size());
+	BoardType::estimateScores(leaves.boards.data(), leaves.size(), leaves.scores.data());
+	
+	// Back values up toward the root, one level per pass
+	for(unsigned i = last; i-- > 0;) {
+		if(i % 2 == 0) {
+			backUpShifts(mLevels[i], mLevels[i + 1], mode);
+		}
+		else {
+			backUpPlaces(mLevels[i], mLevels[i + 1], mode);
+		}
+	}
+	
+	if(last == 0) {
+		return root.scores[0];
+	}
+	
+	// Level 1 holds the legal moves in direction order. Pick the same one as the other engines:
+	// the first with the strictly highest score, else the first legal one.
+	BoardType shifts[4];
+	board.allShifts(shifts);
+	
+	const int* scores = mLevels[1].scores.data();
+	int maxScore = INT_MIN, firstDir = -1, maxDir = -1;
+	for(int i = 0; i < 4; i++) {
+		if(shifts[i].isEmpty()) {
+			continue;
+		}
+		if(firstDir < 0) {
+			firstDir = i;
+		}
+		
+		int score = *scores++;
+		if(score > maxScore) {
+			maxScore = score;
+			maxDir = i;
+		}
+	}
+	if(maxDir < 0) {
+		maxDir = firstDir;
+	}
+	
+	if(dir && maxDir >= 0) {
+		*dir = (Direction)maxDir;
+	}
+	return root.scores[0];
+}
+
+
+template<class BoardType>
+unsigned BasicFrontierSearch<BoardType>::getLastDepth() const {
+	return mLastDepth;
+}
+
+
+template<class BoardType>
+bool BasicFrontierSearch<BoardType>::expandShifts(const Level& from, Level& to) {
+	if(from.size() * 4 > kMaximumLevelSize) {
+		return false;
+	}
+	
+	to.clear();
+	BoardType shifts[4];
+	for(size_t i = 0; i < from.size(); i++) {
+		from.boards[i].allShifts(shifts);
+		for(int j = 0; j < 4; j++) {
+			if(!shifts[j].isEmpty()) {
+				to.boards.push_back(shifts[j]);
+				to.parents.push_back((uint32_t)i);
+			}
+		}
+	}
+	return true;
+}
+
+
+template<class BoardType>
+bool BasicFrontierSearch<BoardType>::expandPlaces(const Level& from, Level& to) {
+	// Counting the holes first is cheap, and it sizes the level exactly
+	size_t count = 0;
+	for(const BoardType& board : from.boards) {
+		count += 2 * __builtin_popcount(board.holeMask());
+	}
+	if(count > kMaximumLevelSize) {
+		return false;
+	}
+	
+	to.clear();
+	to.boards.resize(count);
+	to.parents.resize(count);
+	
+	// allPlaces() writes an even number of boards, so every tile 2 lands on an even index
+	size_t next = 0;
+	for(size_t i = 0; i < from.size(); i++) {
+		unsigned placed = 2 * from.boards[i].allPlaces(&to.boards[next]);
+		for(unsigned j = 0; j < placed; j++) {
+			to.parents[next + j] = (uint32_t)i;
+		}
+		next += placed;
+	}
+	return true;
+}
+
+
+template<class BoardType>
+void BasicFrontierSearch<BoardType>::backUpShifts(Level& parent, const Level& child, SearchMode mode) {
+	parent.scores.assign(parent.size(), INT_MIN);
+	for(size_t i = 0; i < child.size(); i++) {
+		int& score = parent.scores[child.parents[i]];
+		if(child.scores[i] > score) {
+			score = child.scores[i];
+		}
+	}
+	
+	// The pruned engines give a board without moves INT_MIN, which only works with minimum
+	// backups. An average needs the real game over score.
+	if(mode == SearchMode::EXPECTIMAX) {
+		for(size_t i = 0; i < parent.size(); i++) {
+			if(parent.scores[i] == INT_MIN) {
+				parent.scores[i] = parent.boards[i].estimateScore();
+			}
+		}
+	}
+}
+
+
+template<class BoardType>
+void BasicFrontierSearch<BoardType>::backUpPlaces(Level& parent, const Level& child, SearchMode mode) {
+	if(mode == SearchMode::MINIMAX) {
+		parent.scores.assign(parent.size(), INT_MAX);
+		for(size_t i = 0; i < child.size(); i++) {
+			int& score = parent.scores[child.parents[i]];
+			if(child.scores[i] < score) {
+				score = child.scores[i];
+			}
+		}
+		return;
+	}
+	
+	// Each hole is equally likely, then a 2 with 90% and a 4 with 10% probability
+	mSums.assign(parent.size(), 0.0);
+	for(size_t i = 0; i < child.size(); i++) {
+		uint32_t p = child.parents[i];
+		double odds = (i % 2 == 0) ? 0.9 : 0.1;
+		mSums[p] += odds * child.scores[i] / __builtin_popcount(parent.boards[p].holeMask());
+	}
+	
+	parent.scores.resize(parent.size());
+	for(size_t i = 0; i < parent.size(); i++) {
+		parent.scores[i] = (int)lround(mSums[i]);
+	}
+}
+
+
+template class BasicFrontierSearch<Board>;
+template class BasicFrontierSearch<BasicBoard<4, 5>>;
+template class BasicFrontierSearch<BasicBoard<5, 4>>;
@@ -0,0 +1,79 @@
+//
+//  FrontierSearch.h
+//  CAP4053_Minimax
+//
+//  Created by kTeam on 10/19/26.
+//  Copyright © 2026 kTeam. All rights reserved.
+//
+
+#ifndef MM_FRONTIERSEARCH_H
+#define MM_FRONTIERSEARCH_H
+
+#include <cstdint>
+#include <vector>
+#include "Board.h"
+#include "Direction.h"
+#include "SearchBudget.h"
+#include "SearchMode.h"
+
+/**
+ * Full-width search that expands the game tree one level at a time instead of depth-first.
+ * Every level's frontier is stored as parallel arrays of boards, parent indices and scores, so
+ * the leaves are scored in one batch and values are backed up by a reverse pass over each
+ * level. There is no pruning, which suits fixed-depth expectimax where alpha-beta has nothing
+ * to cut anyway. Minimax finds the same move and score as the pruned engines, just slower.
+ *
+ * Even levels hold boards with the player to move (the root is level 0), odd levels hold boards
+ * waiting for a tile. The arrays are kept between searches, so once they've grown to fit a
+ * depth, searches don't allocate.
+ */
+template<class BoardType>
+class BasicFrontierSearch {
+public:
+	/**
+	 * Largest number of boards in one level. A search that would exceed it stops expanding and
+	 * scores the last level it has, so very deep searches come back shallower instead of
+	 * exhausting memory.
+	 */
+	static const size_t kMaximumLevelSize = (size_t)1 << 22;
+	
+	BasicFrontierSearch();
+	
+	/**
+	 * Search @p board to @p depth shifts.
+	 * @param budget Charged one node per board generated, including the root. The result is
+	 *               meaningless once it's exhausted
+	 * @param dir Receives the best move, or any legal move if they all lose
+	 * @return Score of the best move
+	 */
+	int search(BoardType board, unsigned depth, SearchMode mode, SearchBudget& budget, Direction* dir);
+	
+	/**
+	 * Shifts the last search actually looked ahead, less than it was asked for when a level
+	 * would have been too large.
+	 */
+	unsigned getLastDepth() const;
+
+private:
+	struct Level {
+		std::vector<BoardType> boards;
+		std::vector<uint32_t> parents;
+		std::vector<int> scores;
+		
+		void clear();
+		size_t size() const;
+	};
+	
+	bool expandShifts(const Level& from, Level& to);
+	bool expandPlaces(const Level& from, Level& to);
+	void backUpShifts(Level& parent, const Level& child, SearchMode mode);
+	void backUpPlaces(Level& parent, const Level& child, SearchMode mode);
+	
+	std::vector<Level> mLevels;
+	std::vector<double> mSums;
+	unsigned mLastDepth;
+};
+
+typedef BasicFrontierSearch<Board> FrontierSearch;
+
+#endif /* MM_FRONTIERSEARCH_H */
@@ -0,0 +1,179 @@
+//
+//  GameLog.cpp
+//  CAP4053_Minimax
+//
+//  Created by kTeam on 10/19/26.
+//  Copyright © 2026 kTeam. All rights reserved.
+//
+
+#include "GameLog.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+/*
+ * A game log is a 16-byte header followed by packed GameLogRecords in native byte order.
+ * A log cut short by a crash is still readable; a trailing partial record is ignored.
+ */
+struct GameLogHeader {
+	char magic[8];
+	uint32_t formatVersion;
+	uint32_t recordSize;
+};
+
+static_assert(sizeof(GameLogRecord) == 24, "Game log records must have a fixed layout");
+static_assert(sizeof(GameLogHeader) == 16, "Game log header must have a fixed layout");
+
+static const char kMagic[8] = {'M', 'M', 'G', 'A', 'M', 'E', 'L', 'G'};
+static const uint32_t kFormatVersion = 1;
+
+
+static bool writeFully(int fd, const void* data, size_t size) {
+	const char* bytes = (const char*)data;
+	while(size > 0) {
+		ssize_t written = write(fd, bytes, size);
+		if(written < 0) {
+			if(errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		bytes += written;
+		size -= written;
+	}
+	return true;
+}
+
+
+std::unique_ptr<GameLogWriter> GameLogWriter::open(const char* path) {
+	int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(fd < 0) {
+		std::cerr << "Failed to open game log " << path << ": " << strerror(errno) << std::endl;
+		return nullptr;
+	}
+	
+	GameLogHeader header;
+	memcpy(header.magic, kMagic, sizeof(kMagic));
+	header.formatVersion = kFormatVersion;
+	header.recordSize = sizeof(GameLogRecord);
+	if(!writeFully(fd, &header, sizeof(header))) {
+		std::cerr << "Failed to write game log " << path << ": " << strerror(errno) << std::endl;
+		close(fd);
+		return nullptr;
+	}
+	
+	return std::unique_ptr<GameLogWriter>(new GameLogWriter(fd));
+}
+
+
+GameLogWriter::GameLogWriter(int fd)
+: mFd(fd), mCount(0) { }
+
+
+GameLogWriter::~GameLogWriter() {
+	flush();
+	close(mFd);
+}
+
+
+void GameLogWriter::append(Board before, Direction dir, unsigned row, unsigned col, Tile tile,
+                           int score, uint32_t searchMicros, uint64_t searchNodes, uint8_t flags) {
+	GameLogRecord& record = mBuffer[mCount];
+	record.grid = before.getCompressedGrid();
+	record.score = score;
+	record.searchMicros = searchMicros;
+	record.direction = (uint8_t)dir;
+	record.spawnCell = (uint8_t)(row * 4 + col);
+	record.spawnTile = (uint8_t)tile;
+	record.flags = flags;
+	record.searchNodes = searchNodes < UINT32_MAX ? (uint32_t)searchNodes : UINT32_MAX;
+	
+	if(++mCount == kBufferRecords) {
+		flush();
+	}
+}
+
+
+bool GameLogWriter::flush() {
+	bool ok = writeFully(mFd, mBuffer, mCount * sizeof(*mBuffer));
+	if(!ok) {
+		std::cerr << "Failed to write game log: " << strerror(errno) << std::endl;
+	}
+	mCount = 0;
+	return ok;
+}
+
+
+std::unique_ptr<GameLogReader> GameLogReader::open(const char* path) {
+	int fd = ::open(path, O_RDONLY);
+	if(fd < 0) {
+		std::cerr << "Failed to open game log " << path << ": " << strerror(errno) << std::endl;
+		return nullptr;
+	}
+	
+	struct stat st;
+	if(fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(GameLogHeader)) {
+		std::cerr << "Not a game log: " << path << std::endl;
+		close(fd);
+		return nullptr;
+	}
+	
+	// The mapping stays valid after the descriptor is closed
+	size_t mapSize = st.st_size;
+	void* map = mmap(nullptr, mapSize, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(map == MAP_FAILED) {
+		std::cerr << "Failed to map game log " << path << ": " << strerror(errno) << std::endl;
+		return nullptr;
+	}
+	
+	const GameLogHeader* header = (const GameLogHeader*)map;
+	if(memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 ||
+	   header->formatVersion != kFormatVersion ||
+	   header->recordSize != sizeof(GameLogRecord)
+	) {
+		std::cerr << "Not a game log: " << path << std::endl;
+		munmap(map, mapSize);
+		return nullptr;
+	}
+	
+	// Records are read sequentially, so let the kernel read ahead aggressively
+	madvise(map, mapSize, MADV_SEQUENTIAL);
+	return std::unique_ptr<GameLogReader>(new GameLogReader(map, mapSize));
+}
+
+
+GameLogReader::GameLogReader(void* map, size_t mapSize)
+: mMap(map), mMapSize(mapSize),
+  mRecords((const GameLogRecord*)((const char*)map + sizeof(GameLogHeader))),
+  mCount((mapSize - sizeof(GameLogHeader)) / sizeof(GameLogRecord)) { }
+
+
+GameLogReader::~GameLogReader() {
+	munmap(mMap, mMapSize);
+}
+
+
+size_t GameLogReader::size() const {
+	return mCount;
+}
+
+
+const GameLogRecord& GameLogReader::operator[](size_t index) const {
+	return mRecords[index];
+}
+
+
+const GameLogRecord* GameLogReader::begin() const {
+	return mRecords;
+}
+
+
+const GameLogRecord* GameLogReader::end() const {
+	return mRecords + mCount;
+}
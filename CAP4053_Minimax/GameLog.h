@@ -0,0 +1,102 @@
+//
+//  GameLog.h
+//  CAP4053_Minimax
+//
+//  Created by kTeam on 10/19/26.
+//  Copyright © 2026 kTeam. All rights reserved.
+//
+
+#ifndef MM_GAMELOG_H
+#define MM_GAMELOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "Board.h"
+#include "Direction.h"
+
+#define GAMELOG_NEW_GAME (1 << 0)
+#define GAMELOG_HUMAN    (1 << 1)
+
+
+/**
+ * One move in a game log. The layout is fixed so log files can be mapped and read in place.
+ */
+struct GameLogRecord {
+	CompressedGrid grid;     // Board before the move
+	int32_t score;           // Score returned by the search, or zero for human moves
+	uint32_t searchMicros;   // Time spent searching for the move
+	uint8_t direction;       // Direction the tiles were shifted
+	uint8_t spawnCell;       // row * 4 + col of the tile spawned after the move
+	uint8_t spawnTile;       // Tile value (TILE_2 or TILE_4) spawned after the move
+	uint8_t flags;           // GAMELOG_* flags
+	uint32_t searchNodes;    // Nodes the search visited, saturated at UINT32_MAX (zero in older logs)
+};
+
+
+/**
+ * Streams game log records to a file through a fixed-size buffer.
+ */
+class GameLogWriter {
+public:
+	/**
+	 * Create (or truncate) a game log file and write its header.
+	 * @param path Filesystem path of the log file
+	 * @return The opened writer, or nullptr if the file couldn't be created
+	 */
+	static std::unique_ptr<GameLogWriter> open(const char* path);
+	
+	~GameLogWriter();
+	
+	/**
+	 * Append a move to the log. This never allocates; records are written out in batches.
+	 */
+	void append(Board before, Direction dir, unsigned row, unsigned col, Tile tile,
+	            int score, uint32_t searchMicros, uint64_t searchNodes, uint8_t flags = 0);
+	
+	/**
+	 * Write all buffered records to the file.
+	 * @return True on success, or false if the write failed
+	 */
+	bool flush();
+
+private:
+	GameLogWriter(int fd);
+	
+	static const size_t kBufferRecords = 4096;
+	
+	int mFd;
+	size_t mCount;
+	GameLogRecord mBuffer[kBufferRecords];
+};
+
+
+/**
+ * Maps a game log file into memory and exposes its records without copying them.
+ */
+class GameLogReader {
+public:
+	/**
+	 * Map a game log file for reading.
+	 * @param path Filesystem path of the log file
+	 * @return The opened reader, or nullptr if the file is missing or isn't a game log
+	 */
+	static std::unique_ptr<GameLogReader> open(const char* path);
+	
+	~GameLogReader();
+	
+	size_t size() const;
+	const GameLogRecord& operator[](size_t index) const;
+	const GameLogRecord* begin() const;
+	const GameLogRecord* end() const;
+
+private:
+	GameLogReader(void* map, size_t mapSize);
+	
+	void* mMap;
+	size_t mMapSize;
+	const GameLogRecord* mRecords;
+	size_t mCount;
+};
+
+#endif /* MM_GAMELOG_H */
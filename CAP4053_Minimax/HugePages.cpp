@@ -0,0 +1,218 @@
+//
+//  HugePages.cpp
+//  CAP4053_Minimax
+//
+//  Created by kTeam on 10/19/26.
+//  Copyright © 2026 kTeam. All rights reserved.
+//
+
+#include "HugePages.h"
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <sys/mman.h>
+#ifdef __APPLE__
+#include <mach/vm_statistics.h>
+#endif
+
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE 0
+#endif
+
+
+// Address space reserved for the node arena up front, so telling arena nodes from heap nodes is
+// a range check. Only the chunks handed out are ever backed by memory.
+static const size_t kArenaBytes = (size_t)1 << 36;
+
+static std::atomic<bool> sEnabled(false);
+
+// Explicit huge pages are only there if the administrator reserved some, so after the first
+// failure every allocation goes straight to transparent ones
+static std::atomic<bool> sNoExplicitPages(false);
+
+static std::once_flag sArenaOnce;
+static std::atomic<char*> sArenaBase(nullptr);
+static std::atomic<size_t> sArenaChunks(0);
+static thread_local char* sNodeCursor = nullptr;
+static thread_local char* sNodeLimit = nullptr;
+
+
+static size_t roundingUp(size_t bytes) {
+	return (bytes + HugePages::kPageSize - 1) & ~(HugePages::kPageSize - 1);
+}
+
+
+static char* aligningUp(void* memory) {
+	return (char*)(((uintptr_t)memory + HugePages::kPageSize - 1) & ~(uintptr_t)(HugePages::kPageSize - 1));
+}
+
+
+/**
+ * Map @p bytes, a whole number of huge pages, with explicit huge pages at @p address, or
+ * wherever the system picks if it's null.
+ * @return The mapping, or nullptr if the system has no explicit huge pages to give
+ */
+static void* mappingExplicit(void* address, size_t bytes) {
+	if(sNoExplicitPages.load(std::memory_order_relaxed)) {
+		return nullptr;
+	}
+	
+	int flags = MAP_PRIVATE | MAP_ANONYMOUS | (address ? MAP_FIXED : 0);
+#if defined(MAP_HUGETLB)
+	void* memory = mmap(address, bytes, PROT_READ | PROT_WRITE, flags | MAP_HUGETLB, -1, 0);
+#elif defined(VM_FLAGS_SUPERPAGE_SIZE_2MB)
+	void* memory = mmap(address, bytes, PROT_READ | PROT_WRITE, flags, VM_FLAGS_SUPERPAGE_SIZE_2MB, 0);
+#else
+	void* memory = MAP_FAILED;
+#endif
+	if(memory == MAP_FAILED) {
+		sNoExplicitPages = true;
+		return nullptr;
+	}
+	return memory;
+}
+
+
+static void advising(void* memory, size_t bytes) {
+#ifdef MADV_HUGEPAGE
+	madvise(memory, bytes, MADV_HUGEPAGE);
+#else
+	(void)memory;
+	(void)bytes;
+#endif
+}
+
+
+static char* takingChunk() {
+	std::call_once(sArenaOnce, [] {
+		// Reserve a page more than the arena so it can start on a huge page boundary
+		void* memory = mmap(nullptr, kArenaBytes + HugePages::kPageSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if(memory == MAP_FAILED) {
+			std::cerr << "Failed to reserve the node arena: " << strerror(errno) << std::endl;
+			return;
+		}
+		sArenaBase = aligningUp(memory);
+	});
+	
+	char* base = sArenaBase.load();
+	size_t index = sArenaChunks.fetch_add(1);
+	if(!base || index >= kArenaBytes / HugePages::kPageSize) {
+		return nullptr;
+	}
+	
+	char* chunk = base + index * HugePages::kPageSize;
+	if(mappingExplicit(chunk, HugePages::kPageSize)) {
+		return chunk;
+	}
+	if(mmap(chunk, HugePages::kPageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) == MAP_FAILED) {
+		return nullptr;
+	}
+	advising(chunk, HugePages::kPageSize);
+	return chunk;
+}
+
+
+void HugePages::setEnabled(bool enabled) {
+	sEnabled = enabled;
+}
+
+
+bool HugePages::isEnabled() {
+	return sEnabled.load(std::memory_order_relaxed);
+}
+
+
+void* HugePages::allocate(size_t bytes) {
+	bytes = roundingUp(bytes);
+	if(void* memory = mappingExplicit(nullptr, bytes)) {
+		return memory;
+	}
+	
+	// Map a page more than needed, then unmap the ends around the aligned part
+	size_t padded = bytes + kPageSize;
+	void* memory = mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(memory == MAP_FAILED) {
+		std::cerr << "Failed to map " << bytes << " bytes: " << strerror(errno) << std::endl;
+		return nullptr;
+	}
+	char* aligned = aligningUp(memory);
+	if(aligned != memory) {
+		munmap(memory, aligned - (char*)memory);
+	}
+	munmap(aligned + bytes, (char*)memory + padded - (aligned + bytes));
+	
+	advising(aligned, bytes);
+	return aligned;
+}
+
+
+void HugePages::release(void* memory, size_t bytes) {
+	if(memory) {
+		munmap(memory, roundingUp(bytes));
+	}
+}
+
+
+void HugePages::advise(void* memory, size_t bytes) {
+	// The range has to start on a page boundary, and only whole huge pages inside it can be used
+	char* start = aligningUp(memory);
+	char* end = (char*)(((uintptr_t)memory + bytes) & ~(uintptr_t)(kPageSize - 1));
+	if(start < end) {
+		advising(start, end - start);
+	}
+}
+
+
+void* HugePages::allocateNode(size_t bytes, size_t alignment) {
+	if(!isEnabled()) {
+		return nullptr;
+	}
+	
+	// The rest of a chunk too small for the node is left unused
+	uintptr_t cursor = ((uintptr_t)sNodeCursor + alignment - 1) & ~(uintptr_t)(alignment - 1);
+	if(!sNodeCursor || cursor + bytes > (uintptr_t)sNodeLimit) {
+		char* chunk = takingChunk();
+		if(!chunk) {
+			return nullptr;
+		}
+		cursor = (uintptr_t)chunk;
+		sNodeLimit = chunk + kPageSize;
+	}
+	sNodeCursor = (char*)(cursor + bytes);
+	return (void*)cursor;
+}
+
+
+bool HugePages::isArenaNode(const void* memory) {
+	const char* base = sArenaBase.load(std::memory_order_relaxed);
+	return base && (const char*)memory >= base && (const char*)memory < base + kArenaBytes;
+}
+
+
+size_t HugePages::getHugeBytes() {
+	// Only Linux says, through procfs
+	FILE* file = fopen("/proc/self/smaps_rollup", "r");
+	if(!file) {
+		return 0;
+	}
+	
+	size_t total = 0;
+	char line[256];
+	while(fgets(line, sizeof(line), file)) {
+		unsigned long long kilobytes;
+		if(sscanf(line, "AnonHugePages: %llu kB", &kilobytes) == 1 ||
+		   sscanf(line, "Private_Hugetlb: %llu kB", &kilobytes) == 1 ||
+		   sscanf(line, "Shared_Hugetlb: %llu kB", &kilobytes) == 1) {
+			total += kilobytes * 1024;
+		}
+	}
+	fclose(file);
+	return total;
+}
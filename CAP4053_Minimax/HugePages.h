@@ -0,0 +1,58 @@
+//
+//  HugePages.h
+//  CAP4053_Minimax
+//
+//  Created by kTeam on 10/19/26.
+//  Copyright © 2026 kTeam. All rights reserved.
+//
+
+#ifndef MM_HUGEPAGES_H
+#define MM_HUGEPAGES_H
+
+#include <cstddef>
+
+/**
+ * Optional 2 MB page backing for the memory searches touch at random: the line tables, the tree
+ * nodes and the score cache. With 4 KB pages a deep search misses the dTLB on most of those
+ * lookups. Explicit huge pages are used where the system has some reserved, else transparent
+ * huge pages where it supports them, else regular pages, so enabling this never breaks anything.
+ *
+ * Enable it before filling the tables, since Board::fillShiftTable() is what moves them.
+ */
+class HugePages {
+public:
+	static const size_t kPageSize = 2 << 20;
+	
+	static void setEnabled(bool enabled);
+	static bool isEnabled();
+	
+	/**
+	 * Zeroed memory of @p bytes rounded up to whole huge pages, aligned to one.
+	 * @return nullptr if no memory could be mapped at all
+	 */
+	static void* allocate(size_t bytes);
+	static void release(void* memory, size_t bytes);
+	
+	/**
+	 * Ask for huge pages on memory mapped elsewhere, like a cache file. Most systems only give
+	 * anonymous memory huge pages, so this is best effort.
+	 */
+	static void advise(void* memory, size_t bytes);
+	
+	/**
+	 * Memory for a tree node from a process-wide arena of huge pages. Each thread carves nodes
+	 * out of its own 2 MB chunk, so this doesn't synchronize except to take a new chunk. Arena
+	 * memory can't be freed one node at a time, so node pools keep arena nodes for good.
+	 * @return nullptr when huge pages are disabled or the arena can't grow
+	 */
+	static void* allocateNode(size_t bytes, size_t alignment);
+	static bool isArenaNode(const void* memory);
+	
+	/**
+	 * Bytes of this process in huge pages, explicit or transparent, or zero where the system
+	 * doesn't say.
+	 */
+	static size_t getHugeBytes();
+};
+
+#endif /* MM_HUGEPAGES_H */
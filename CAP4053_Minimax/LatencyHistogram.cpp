@@ -0,0 +1,168 @@
+//
+//  LatencyHistogram.cpp
+//  CAP4053_Minimax
+//
+//  Created by kTeam on 10/19/26.
+//  Copyright © 2026 kTeam. All rights reserved.
+//
+
+#include "LatencyHistogram.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+LatencyHistogram::LatencyHistogram() {
+	reset();
+}
+
+
+unsigned LatencyHistogram::bucketOf(uint64_t nanos) {
+	// Below 2 * kSubBuckets every duration has its own bucket. Above, each power of two is split
+	// by the bits after its leading one.
+	if(nanos < 2 * kSubBuckets) {
+		return (unsigned)nanos;
+	}
+	unsigned shift = 63 - __builtin_clzll(nanos) - kSubBucketBits;
+	return shift * kSubBuckets + (unsigned)(nanos >> shift);
+}
+
+
+uint64_t LatencyHistogram::highestIn(unsigned bucket) {
+	if(bucket < 2 * kSubBuckets) {
+		return bucket;
+	}
+	unsigned shift = bucket / kSubBuckets - 1;
+	uint64_t lead = bucket % kSubBuckets + kSubBuckets;
+	return ((lead + 1) << shift) - 1;
+}
+
+
+void LatencyHistogram::record(uint64_t nanos) {
+	++mCounts[bucketOf(nanos)];
+	++mCount;
+	mMax = std::max(mMax, nanos);
+	mTotal += nanos;
+}
+
+
+void LatencyHistogram::add(const LatencyHistogram& other) {
+	for(unsigned i = 0; i < kBucketCount; i++) {
+		mCounts[i] += other.mCounts[i];
+	}
+	mCount += other.mCount;
+	mMax = std::max(mMax, other.mMax);
+	mTotal += other.mTotal;
+}
+
+
+void LatencyHistogram::reset() {
+	memset(mCounts, 0, sizeof(mCounts));
+	mCount = 0;
+	mMax = 0;
+	mTotal = 0;
+}
+
+
+uint64_t LatencyHistogram::getCount() const {
+	return mCount;
+}
+
+
+uint64_t LatencyHistogram::getMax() const {
+	return mMax;
+}
+
+
+double LatencyHistogram::getMean() const {
+	return mCount ? (double)mTotal / mCount : 0.0;
+}
+
+
+uint64_t LatencyHistogram::getPercentile(double percent) const {
+	if(mCount == 0) {
+		return 0;
+	}
+	
+	// The rank of the duration asked for, counting from 1, so the 0th percentile is the shortest
+	uint64_t rank = (uint64_t)std::ceil(std::min(std::max(percent, 0.0), 100.0) / 100.0 * mCount);
+	rank = std::max<uint64_t>(rank, 1);
+	uint64_t seen = 0;
+	for(unsigned i = 0; i < kBucketCount; i++) {
+		seen += mCounts[i];
+		if(seen >= rank) {
+			return std::min(highestIn(i), mMax);
+		}
+	}
+	return mMax;
+}
+
+
+MoveLatencies::MoveLatencies() { }
+
+
+void MoveLatencies::record(unsigned holes, unsigned maxTile, uint64_t nanos) {
+	holes = std::min(holes, kHoleBuckets - 1);
+	maxTile = std::min(maxTile, kTileBuckets - 1);
+	std::unique_ptr<LatencyHistogram>& histogram = mHistograms[holes][maxTile];
+	if(!histogram) {
+		histogram.reset(new LatencyHistogram());
+	}
+	histogram->record(nanos);
+}
+
+
+void MoveLatencies::reset() {
+	for(unsigned holes = 0; holes < kHoleBuckets; holes++) {
+		for(unsigned tile = 0; tile < kTileBuckets; tile++) {
+			mHistograms[holes][tile].reset();
+		}
+	}
+}
+
+
+const LatencyHistogram* MoveLatencies::find(unsigned holes, unsigned maxTile) const {
+	if(holes >= kHoleBuckets || maxTile >= kTileBuckets) {
+		return nullptr;
+	}
+	return mHistograms[holes][maxTile].get();
+}
+
+
+LatencyHistogram MoveLatencies::getTotal(unsigned maxHoles) const {
+	LatencyHistogram ret;
+	for(unsigned holes = 0; holes <= maxHoles && holes < kHoleBuckets; holes++) {
+		for(unsigned tile = 0; tile < kTileBuckets; tile++) {
+			if(mHistograms[holes][tile]) {
+				ret.add(*mHistograms[holes][tile]);
+			}
+		}
+	}
+	return ret;
+}
+
+
+static void printingRow(FILE* out, const char* holes, const char* tile, const LatencyHistogram& histogram) {
+	fprintf(out, "%5s %8s %8llu %9.1f %9.1f %9.1f %9.1f %9.1f\n", holes, tile,
+		(unsigned long long)histogram.getCount(), histogram.getMean() / 1e3, histogram.getPercentile(50) / 1e3,
+		histogram.getPercentile(99) / 1e3, histogram.getPercentile(99.9) / 1e3, histogram.getMax() / 1e3);
+}
+
+
+void MoveLatencies::print(FILE* out) const {
+	fprintf(out, "%5s %8s %8s %9s %9s %9s %9s %9s\n", "empty", "max tile", "moves", "mean us", "p50 us", "p99 us", "p99.9 us", "max us");
+	
+	// Crowded boards first, where the tail comes from
+	for(unsigned holes = 0; holes < kHoleBuckets; holes++) {
+		for(unsigned tile = 0; tile < kTileBuckets; tile++) {
+			if(!mHistograms[holes][tile]) {
+				continue;
+			}
+			char holesText[16], tileText[16];
+			snprintf(holesText, sizeof(holesText), "%u", holes);
+			snprintf(tileText, sizeof(tileText), "%llu", tile ? 1ull << tile : 0ull);
+			printingRow(out, holesText, tileText, *mHistograms[holes][tile]);
+		}
+	}
+	printingRow(out, "all", "", getTotal());
+}
@@ -0,0 +1,93 @@
+//
+//  LatencyHistogram.h
+//  CAP4053_Minimax
+//
+//  Created by kTeam on 10/19/26.
+//  Copyright © 2026 kTeam. All rights reserved.
+//
+
+#ifndef MM_LATENCYHISTOGRAM_H
+#define MM_LATENCYHISTOGRAM_H
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+
+
+/**
+ * Counts of durations in nanoseconds, in the log-linear buckets of an HDR histogram: every power
+ * of two is split into 32 buckets, so any percentile is within about 3% of the true value from
+ * a nanosecond up to centuries, in a fixed 15 KiB.
+ */
+class LatencyHistogram {
+public:
+	LatencyHistogram();
+	
+	void record(uint64_t nanos);
+	void add(const LatencyHistogram& other);
+	void reset();
+	
+	uint64_t getCount() const;
+	uint64_t getMax() const;
+	double getMean() const;
+	
+	/**
+	 * Duration @p percent percent of the recorded ones are at most, rounded up to the top of its
+	 * bucket but never past the longest, or 0 if nothing was recorded.
+	 */
+	uint64_t getPercentile(double percent) const;
+
+private:
+	static const unsigned kSubBucketBits = 5;
+	static const unsigned kSubBuckets = 1u << kSubBucketBits;
+	static const unsigned kBucketCount = (64 - kSubBucketBits + 1) * kSubBuckets;
+	
+	static unsigned bucketOf(uint64_t nanos);
+	static uint64_t highestIn(unsigned bucket);
+	
+	uint64_t mCounts[kBucketCount];
+	uint64_t mCount;
+	uint64_t mMax;
+	uint64_t mTotal;
+};
+
+
+/**
+ * How long every move took to pick, bucketed by the empty cells and the largest tile of the
+ * board it was picked on. Crowded boards are searched deeper and dominate the tail, which an
+ * average over the whole game hides.
+ */
+class MoveLatencies {
+public:
+	// Enough for 5x5 boards and 5-bit tiles
+	static const unsigned kHoleBuckets = 26;
+	static const unsigned kTileBuckets = 32;
+	
+	MoveLatencies();
+	
+	void record(unsigned holes, unsigned maxTile, uint64_t nanos);
+	void reset();
+	
+	/**
+	 * Moves picked with @p holes empty cells and @p maxTile as the largest tile, or nullptr if
+	 * there were none.
+	 */
+	const LatencyHistogram* find(unsigned holes, unsigned maxTile) const;
+	
+	/**
+	 * Every move, whatever its board, or only those with at most @p maxHoles empty cells.
+	 */
+	LatencyHistogram getTotal(unsigned maxHoles = kHoleBuckets - 1) const;
+	
+	/**
+	 * Write a table of the moves, percentiles and longest move for every bucket with any
+	 * moves, and the totals, in microseconds.
+	 */
+	void print(FILE* out) const;
+
+private:
+	// Allocated on a bucket's first move, as most combinations never happen
+	std::unique_ptr<LatencyHistogram> mHistograms[kHoleBuckets][kTileBuckets];
+};
+
+#endif /* MM_LATENCYHISTOGRAM_H */
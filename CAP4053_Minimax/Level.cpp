@@ -9,13 +9,17 @@
 #include "Level.h"
 #include <iostream>
 #include <fstream>
+#include <chrono>
 #include <cmath>
 #include <cstdlib>
 #include "helpers.h"
 
+// Discarded tree nodes freed per idle frame, well under a millisecond's work
+static const size_t kIdleReclaimNodes = 1 << 14;
+
 
 Level::Level(sf::RenderTarget& target)
-: mCanvas(target), mTextures(std::make_shared<TextureAtlas>(resourcePath() + "sprites.pack")), mAIEnabled(false) {
+: mCanvas(target), mTextures(std::make_shared<TextureAtlas>(resourcePath() + "sprites.pack")), mAIEnabled(false), mNewGame(true) {
 	// Load font
 	mFont = std::make_shared<sf::Font>();
 	if(!mFont->loadFromFile(resourcePath() + "ClearSans-Bold.ttf")) {
@@ -30,6 +34,26 @@ Level::Level(sf::RenderTarget& target)
 	// Create AI
 	mMinimax = std::make_unique<BoardTree>(*mBoard);
 	
+	// Cap each search by node count rather than depth, so every move costs about the same
+	if(const char* budgetText = getenv("MM_NODE_BUDGET")) {
+		mMinimax->setNodeBudget(strtoull(budgetText, nullptr, 10));
+	}
+	
+	// Bound the memory the tree keeps between moves, for long sessions
+	if(const char* memoryText = getenv("MM_TREE_MEMORY")) {
+		mMinimax->setMemoryBudget(strtoull(memoryText, nullptr, 10));
+	}
+	
+	// Log the hardware events of each search alongside the move
+	if(getenv("MM_PERF_COUNTERS")) {
+		mMinimax->setCounting(true);
+	}
+	
+	// Record every move in a binary game log if one was requested
+	if(const char* logPath = getenv("MM_GAME_LOG")) {
+		mGameLog = GameLogWriter::open(logPath);
+	}
+	
 	// Move the board into position (centered at the bottom of the window)
 	float distanceToEdge = (600 - mBoard->kBoardWidth) / 2.0f;
 	float halfBoard = mBoard->kBoardWidth / 2.0f;
@@ -60,19 +84,23 @@ Level::Level(sf::RenderTarget& target)
 	mInstructions.setPosition(600 / 2.0f, titleBox.top + titleBox.height + 50.0f);
 }
 
+Level::~Level() {
+	if(mMinimax->getLatencies().getTotal().getCount()) {
+		printLatencies();
+	}
+}
+
 void Level::update(float deltaTime) {
 	if(mAIEnabled && !mBoard->checkGameOver()) {
-		bool didMove = mBoard->shiftTiles(mMinimax->getBestMove());
-		if(didMove) {
-			unsigned row, col;
-			Tile tile;
-			mBoard->placeRandom(&row, &col, &tile);
-			mMinimax->placedTile(row, col, tile);
-			mBoard->print();
-			if(mBoard->isGameOver()) {
-				std::cout << "Game over!" << std::endl;
-			}
-		}
+		auto searchStart = std::chrono::steady_clock::now();
+		Direction dir = mMinimax->getBestMove();
+		auto searchTime = std::chrono::steady_clock::now() - searchStart;
+		uint32_t searchMicros = (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(searchTime).count();
+		playMove(dir, mMinimax->getLastScore(), searchMicros, mMinimax->getNodeCount(), 0);
+	}
+	else {
+		// Nothing to search this frame, so free some of the subtrees earlier moves discarded
+		BoardTree::reclaim(kIdleReclaimNodes);
 	}
 }
 
@@ -83,35 +111,35 @@ void Level::draw(float deltaTime) {
 }
 
 void Level::keyPressed(sf::Keyboard::Key key) {
-	bool didMove = false;
 	switch(key) {
 		case sf::Keyboard::Up:
 		case sf::Keyboard::W:
 		case sf::Keyboard::K:
-			didMove = mBoard->shiftTilesUp();
+			playMove(Direction::UP, 0, 0, 0, GAMELOG_HUMAN);
 			break;
 		
 		case sf::Keyboard::Left:
 		case sf::Keyboard::A:
 		case sf::Keyboard::H:
-			didMove = mBoard->shiftTilesLeft();
+			playMove(Direction::LEFT, 0, 0, 0, GAMELOG_HUMAN);
 			break;
 		
 		case sf::Keyboard::Down:
 		case sf::Keyboard::S:
 		case sf::Keyboard::J:
-			didMove = mBoard->shiftTilesDown();
+			playMove(Direction::DOWN, 0, 0, 0, GAMELOG_HUMAN);
 			break;
 		
 		case sf::Keyboard::Right:
 		case sf::Keyboard::D:
 		case sf::Keyboard::L:
-			didMove = mBoard->shiftTilesRight();
+			playMove(Direction::RIGHT, 0, 0, 0, GAMELOG_HUMAN);
 			break;
 		
 		case sf::Keyboard::R:
 			mBoard->tryAgain();
 			mMinimax->setBoard(*mBoard);
+			mNewGame = true;
 			break;
 		
 		case sf::Keyboard::Space:
@@ -121,22 +149,47 @@ void Level::keyPressed(sf::Keyboard::Key key) {
 			}
 			break;
 		
+		// Not in the instructions, which have no room left above the board
+		case sf::Keyboard::T:
+			printLatencies();
+			break;
+		
 		default:
 			break;
 	}
+}
+
+bool Level::playMove(Direction dir, int score, uint32_t searchMicros, uint64_t searchNodes, uint8_t flags) {
+	Board before = *mBoard;
+	if(!mBoard->shiftTiles(dir)) {
+		return false;
+	}
 	
-	if(didMove) {
-		unsigned row, col;
-		Tile tile;
-		mBoard->placeRandom(&row, &col, &tile);
-		if(mAIEnabled) {
-			mMinimax->placedTile(row, col, tile);
-		}
-		mBoard->print();
-		if(mBoard->isGameOver()) {
-			std::cout << "Game over!" << std::endl;
+	unsigned row, col;
+	Tile tile;
+	mBoard->placeRandom(&row, &col, &tile);
+	if(mAIEnabled) {
+		mMinimax->placedTile(row, col, tile);
+	}
+	
+	if(mGameLog) {
+		if(mNewGame) {
+			flags |= GAMELOG_NEW_GAME;
 		}
+		mGameLog->append(before, dir, row, col, tile, score, searchMicros, searchNodes, flags);
 	}
+	mNewGame = false;
+	
+	mBoard->print();
+	if(mBoard->isGameOver()) {
+		std::cout << "Game over!" << std::endl;
+	}
+	return true;
+}
+
+void Level::printLatencies() const {
+	std::cerr << "AI move latencies:" << std::endl;
+	mMinimax->getLatencies().print(stderr);
 }
 
 void Level::keyReleased(sf::Keyboard::Key key) {
@@ -15,6 +15,7 @@
 #include "Engine/TextureAtlas.h"
 #include "DrawableBoard.h"
 #include "BoardTree.h"
+#include "GameLog.h"
 
 
 /**
@@ -29,6 +30,11 @@ public:
 	 */
 	Level(sf::RenderTarget& canvas);
 	
+	/**
+	 * Prints how long the AI's moves took, if it made any.
+	 */
+	~Level();
+	
 	/**
 	 * Update game objects while playing.
 	 * @param deltaTime Time in seconds elapsed since last update call
@@ -75,6 +81,22 @@ public:
 	void mouseMoved(int x, int y);
 	
 private:
+	/**
+	 * Shift the board, spawn a new tile, and record the move in the game log if one is open.
+	 * @param dir Direction in which to shift the tiles
+	 * @param score Score the search gave this move, or zero for human moves
+	 * @param searchMicros Time spent searching for this move
+	 * @param searchNodes Nodes the search visited for this move
+	 * @param flags GAMELOG_* flags describing the move
+	 * @return True if any tiles moved
+	 */
+	bool playMove(Direction dir, int score, uint32_t searchMicros, uint64_t searchNodes, uint8_t flags);
+	
+	/**
+	 * Print the AI's move latencies so far, by empty cells and largest tile, to stderr.
+	 */
+	void printLatencies() const;
+	
 	sf::RenderTarget& mCanvas;
 	std::shared_ptr<TextureAtlas> mTextures;
 	std::shared_ptr<sf::Font> mFont;
@@ -82,7 +104,9 @@ private:
 	sf::Text mTitle;
 	sf::Text mInstructions;
 	std::unique_ptr<BoardTree> mMinimax;
+	std::unique_ptr<GameLogWriter> mGameLog;
 	bool mAIEnabled;
+	bool mNewGame;
 };
 
 #endif /* MM_LEVEL_H */
@@ -0,0 +1,257 @@
+//
+//  NTupleEvaluator.cpp
+//  CAP4053_Minimax
+//
+//  Created by kTeam on 10/19/26.
+//  Copyright © 2026 kTeam. All rights reserved.
+//
+
+#include "NTupleEvaluator.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include "BoardPrivate.h"
+
+
+/*
+ * Weights file layout, all fields in native byte order:
+ *
+ *   char magic[8]                  "MMNTUPLE"
+ *   uint32_t formatVersion
+ *   uint32_t tupleCount
+ *   for each tuple:
+ *     uint32_t cellCount
+ *     uint32_t cells[cellCount]    row * 4 + col
+ *   for each tuple:
+ *     float weights[16 ** cellCount]
+ */
+static const char kMagic[8] = {'M', 'M', 'N', 'T', 'U', 'P', 'L', 'E'};
+static const uint32_t kFormatVersion = 1;
+
+
+static inline CompressedGrid mirroringGrid(CompressedGrid grid) {
+	// Reverse the order of the tiles within each row
+	return ((grid & 0x000f000f000f000f) << 12) | ((grid & 0x00f000f000f000f0) << 4) |
+	       ((grid & 0x0f000f000f000f00) >> 4) | ((grid & 0xf000f000f000f000) >> 12);
+}
+
+static inline CompressedGrid flippingGrid(CompressedGrid grid) {
+	// Reverse the order of the rows
+	return ((grid & 0x000000000000ffff) << 48) | ((grid & 0x00000000ffff0000) << 16) |
+	       ((grid & 0x0000ffff00000000) >> 16) | ((grid & 0xffff000000000000) >> 48);
+}
+
+
+/*
+ * Weights are shared between training threads without locks, so every access is a relaxed
+ * atomic. On every platform we target these compile to ordinary loads and stores.
+ */
+static inline float loadingWeight(const float* weight) {
+	float ret;
+	__atomic_load(weight, &ret, __ATOMIC_RELAXED);
+	return ret;
+}
+
+static inline void storingWeight(float* weight, float value) {
+	__atomic_store(weight, &value, __ATOMIC_RELAXED);
+}
+
+
+NTupleEvaluator::PatternList NTupleEvaluator::defaultPatterns() {
+	return {
+		{0, 1, 2, 3},
+		{4, 5, 6, 7},
+		{0, 1, 2, 4, 5, 6},
+		{4, 5, 6, 8, 9, 10}
+	};
+}
+
+
+NTupleEvaluator::NTupleEvaluator(const PatternList& patterns)
+: mPatterns(patterns) {
+	size_t weightCount = 0;
+	for(const std::vector<unsigned>& pattern : mPatterns) {
+		Tuple tuple;
+		tuple.cellCount = (unsigned)pattern.size();
+		for(unsigned i = 0; i < tuple.cellCount; i++) {
+			tuple.shifts[i] = MAKE_SHIFT(pattern[i] / 4, pattern[i] % 4);
+		}
+		tuple.offset = weightCount;
+		weightCount += (size_t)1 << (TILE_BITS * tuple.cellCount);
+		mTuples.push_back(tuple);
+	}
+	
+	mWeights.assign(weightCount, 0.0f);
+}
+
+
+std::unique_ptr<NTupleEvaluator> NTupleEvaluator::load(const char* path) {
+	FILE* fp = fopen(path, "rb");
+	if(!fp) {
+		std::cerr << "Failed to open n-tuple weights " << path << std::endl;
+		return nullptr;
+	}
+	
+	char magic[sizeof(kMagic)];
+	uint32_t formatVersion, tupleCount;
+	if(fread(magic, sizeof(magic), 1, fp) != 1 || memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+	   fread(&formatVersion, sizeof(formatVersion), 1, fp) != 1 || formatVersion != kFormatVersion ||
+	   fread(&tupleCount, sizeof(tupleCount), 1, fp) != 1 || tupleCount == 0 || tupleCount > 64
+	) {
+		std::cerr << "Not an n-tuple weights file: " << path << std::endl;
+		fclose(fp);
+		return nullptr;
+	}
+	
+	PatternList patterns(tupleCount);
+	for(std::vector<unsigned>& pattern : patterns) {
+		uint32_t cellCount;
+		if(fread(&cellCount, sizeof(cellCount), 1, fp) != 1 || cellCount == 0 || cellCount > kMaxTupleCells) {
+			std::cerr << "Bad tuple in n-tuple weights file: " << path << std::endl;
+			fclose(fp);
+			return nullptr;
+		}
+		
+		uint32_t cells[kMaxTupleCells];
+		if(fread(cells, sizeof(*cells), cellCount, fp) != cellCount) {
+			std::cerr << "Truncated n-tuple weights file: " << path << std::endl;
+			fclose(fp);
+			return nullptr;
+		}
+		
+		for(uint32_t i = 0; i < cellCount; i++) {
+			if(cells[i] >= 16) {
+				std::cerr << "Bad tuple in n-tuple weights file: " << path << std::endl;
+				fclose(fp);
+				return nullptr;
+			}
+			pattern.push_back(cells[i]);
+		}
+	}
+	
+	std::unique_ptr<NTupleEvaluator> evaluator(new NTupleEvaluator(patterns));
+	size_t weightCount = evaluator->mWeights.size();
+	if(fread(evaluator->mWeights.data(), sizeof(float), weightCount, fp) != weightCount) {
+		std::cerr << "Truncated n-tuple weights file: " << path << std::endl;
+		fclose(fp);
+		return nullptr;
+	}
+	
+	fclose(fp);
+	return evaluator;
+}
+
+
+bool NTupleEvaluator::save(const char* path) const {
+	FILE* fp = fopen(path, "wb");
+	if(!fp) {
+		std::cerr << "Failed to create n-tuple weights " << path << std::endl;
+		return false;
+	}
+	
+	bool ok = fwrite(kMagic, sizeof(kMagic), 1, fp) == 1 &&
+		fwrite(&kFormatVersion, sizeof(kFormatVersion), 1, fp) == 1;
+	
+	uint32_t tupleCount = (uint32_t)mPatterns.size();
+	ok = ok && fwrite(&tupleCount, sizeof(tupleCount), 1, fp) == 1;
+	for(const std::vector<unsigned>& pattern : mPatterns) {
+		uint32_t cellCount = (uint32_t)pattern.size();
+		ok = ok && fwrite(&cellCount, sizeof(cellCount), 1, fp) == 1;
+		for(unsigned cell : pattern) {
+			uint32_t cell32 = cell;
+			ok = ok && fwrite(&cell32, sizeof(cell32), 1, fp) == 1;
+		}
+	}
+	
+	ok = ok && fwrite(mWeights.data(), sizeof(float), mWeights.size(), fp) == mWeights.size();
+	if(fclose(fp) != 0) {
+		ok = false;
+	}
+	
+	if(!ok) {
+		std::cerr << "Failed to write n-tuple weights " << path << std::endl;
+	}
+	return ok;
+}
+
+
+void NTupleEvaluator::symmetries(CompressedGrid grid, CompressedGrid* grids) {
+	CompressedGrid transposed = transposingGrid(grid);
+	grids[0] = grid;
+	grids[1] = mirroringGrid(grid);
+	grids[2] = flippingGrid(grid);
+	grids[3] = flippingGrid(grids[1]);
+	grids[4] = transposed;
+	grids[5] = mirroringGrid(transposed);
+	grids[6] = flippingGrid(transposed);
+	grids[7] = flippingGrid(grids[5]);
+}
+
+
+inline uint32_t NTupleEvaluator::tupleIndex(const Tuple& tuple, CompressedGrid grid) {
+	uint32_t index = 0;
+	for(unsigned i = 0; i < tuple.cellCount; i++) {
+		index |= (uint32_t)EXTRACT_TILE(grid, tuple.shifts[i]) << (TILE_BITS * i);
+	}
+	return index;
+}
+
+
+float NTupleEvaluator::value(CompressedGrid grid) const {
+	CompressedGrid grids[8];
+	symmetries(grid, grids);
+	
+	const float* weights = mWeights.data();
+	float sum = 0.0f;
+	for(const Tuple& tuple : mTuples) {
+		const float* table = weights + tuple.offset;
+		for(int i = 0; i < 8; i++) {
+			sum += loadingWeight(&table[tupleIndex(tuple, grids[i])]);
+		}
+	}
+	return sum;
+}
+
+
+void NTupleEvaluator::update(CompressedGrid grid, float delta) {
+	CompressedGrid grids[8];
+	symmetries(grid, grids);
+	
+	float* weights = mWeights.data();
+	for(const Tuple& tuple : mTuples) {
+		float* table = weights + tuple.offset;
+		for(int i = 0; i < 8; i++) {
+			float* weight = &table[tupleIndex(tuple, grids[i])];
+			storingWeight(weight, loadingWeight(weight) + delta);
+		}
+	}
+}
+
+
+int NTupleEvaluator::evaluate(CompressedGrid grid) const {
+	return (int)lroundf(value(grid));
+}
+
+
+uint64_t NTupleEvaluator::version() const {
+	// FNV-1a over the patterns and every weight
+	uint64_t hash = 0xcbf29ce484222325;
+	for(const std::vector<unsigned>& pattern : mPatterns) {
+		for(unsigned cell : pattern) {
+			hash = (hash ^ cell) * 0x100000001b3;
+		}
+		hash = (hash ^ 0xff) * 0x100000001b3;
+	}
+	
+	const uint8_t* bytes = (const uint8_t*)mWeights.data();
+	for(size_t i = 0; i < mWeights.size() * sizeof(float); i++) {
+		hash = (hash ^ bytes[i]) * 0x100000001b3;
+	}
+	return hash;
+}
+
+
+const NTupleEvaluator::PatternList& NTupleEvaluator::getPatterns() const {
+	return mPatterns;
+}
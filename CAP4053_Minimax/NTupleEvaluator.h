@@ -0,0 +1,88 @@
+//
+//  NTupleEvaluator.h
+//  CAP4053_Minimax
+//
+//  Created by kTeam on 10/19/26.
+//  Copyright © 2026 kTeam. All rights reserved.
+//
+
+#ifndef MM_NTUPLEEVALUATOR_H
+#define MM_NTUPLEEVALUATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Evaluator.h"
+
+
+/**
+ * Learned evaluator made of n-tuples: small patterns of cells whose tiles, read straight out
+ * of the CompressedGrid nybbles, index a table of weights. The value of a position is the sum
+ * of every tuple's weight over all 8 rotations and reflections of the board.
+ */
+class NTupleEvaluator: public Evaluator {
+public:
+	/**
+	 * Cells (row * 4 + col) covered by each tuple. Tuples may have 1 to 6 cells.
+	 */
+	typedef std::vector<std::vector<unsigned>> PatternList;
+	
+	static const unsigned kMaxTupleCells = 6;
+	
+	/**
+	 * Two straight 4-tuples and two 2x3 6-tuples, which together cover every cell.
+	 */
+	static PatternList defaultPatterns();
+	
+	/**
+	 * Load the patterns and weights from a file written by save().
+	 * @param path Filesystem path of the weights file
+	 * @return The loaded evaluator, or nullptr if the file is missing or malformed
+	 */
+	static std::unique_ptr<NTupleEvaluator> load(const char* path);
+	
+	/**
+	 * Create an evaluator with every weight set to zero.
+	 */
+	NTupleEvaluator(const PatternList& patterns);
+	
+	/**
+	 * Write the patterns and weights to a file.
+	 * @return True on success, or false if the file couldn't be written
+	 */
+	bool save(const char* path) const;
+	
+	virtual int evaluate(CompressedGrid grid) const override;
+	virtual uint64_t version() const override;
+	
+	/**
+	 * Unrounded value of a position.
+	 */
+	float value(CompressedGrid grid) const;
+	
+	/**
+	 * Add @p delta to the weight of every tuple in every symmetry of the position. Threads may
+	 * call this concurrently with each other and with value(); a racing update can be lost but
+	 * never torn, which is the usual Hogwild trade-off.
+	 */
+	void update(CompressedGrid grid, float delta);
+	
+	const PatternList& getPatterns() const;
+
+private:
+	struct Tuple {
+		unsigned cellCount;
+		int shifts[kMaxTupleCells];
+		size_t offset;
+	};
+	
+	static void symmetries(CompressedGrid grid, CompressedGrid* grids);
+	static inline uint32_t tupleIndex(const Tuple& tuple, CompressedGrid grid);
+	
+	PatternList mPatterns;
+	std::vector<Tuple> mTuples;
+	std::vector<float> mWeights;
+};
+
+#endif /* MM_NTUPLEEVALUATOR_H */
@@ -0,0 +1,76 @@
+//
+//  NodeBounds.h
+//  CAP4053_Minimax
+//
+//  Created by kTeam on 10/19/26.
+//  Copyright © 2026 kTeam. All rights reserved.
+//
+
+#ifndef MM_NODEBOUNDS_H
+#define MM_NODEBOUNDS_H
+
+#include <climits>
+
+/**
+ * What earlier searches of a tree node learned about its score at one depth. Zero-window
+ * searches only learn bounds, so PVS re-searches and MTD(f) probes revisit the same nodes
+ * many times, and these bounds let most of those visits return at once.
+ */
+struct NodeBounds {
+	unsigned depth;
+	int lower;
+	int upper;
+	
+	void reset() {
+		depth = 0;
+		lower = INT_MIN;
+		upper = INT_MAX;
+	}
+	
+	/**
+	 * Narrow the window (@p alpha, @p beta) for a search to @p searchDepth.
+	 * @return True and the score in @p score when the bounds alone answer the search
+	 */
+	bool probing(unsigned searchDepth, int& alpha, int& beta, int* score) const {
+		if(depth != searchDepth) {
+			return false;
+		}
+		if(lower >= beta || lower == upper) {
+			*score = lower;
+			return true;
+		}
+		if(upper <= alpha) {
+			*score = upper;
+			return true;
+		}
+		if(lower > alpha) {
+			alpha = lower;
+		}
+		if(upper < beta) {
+			beta = upper;
+		}
+		return false;
+	}
+	
+	/**
+	 * Record the fail-soft result of a search to @p searchDepth with the window (@p alpha, @p beta).
+	 */
+	void store(unsigned searchDepth, int alpha, int beta, int score) {
+		if(depth != searchDepth) {
+			depth = searchDepth;
+			lower = INT_MIN;
+			upper = INT_MAX;
+		}
+		if(score <= alpha) {
+			upper = score;
+		}
+		else if(score >= beta) {
+			lower = score;
+		}
+		else {
+			lower = upper = score;
+		}
+	}
+};
+
+#endif /* MM_NODEBOUNDS_H */
@@ -0,0 +1,225 @@
+//
+//  NodePool.h
+//  CAP4053_Minimax
+//
+//  Created by kTeam on 10/19/26.
+//  Copyright © 2026 kTeam. All rights reserved.
+//
+
+#ifndef MM_NODEPOOL_H
+#define MM_NODEPOOL_H
+
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <vector>
+#include "HugePages.h"
+
+/**
+ * Freed tree nodes of one type, for reuse instead of new and delete. Each thread keeps its own
+ * cache, so allocating and freeing never synchronize. A thread that frees more than it
+ * allocates, say after tearing down a big subtree, hands the excess in batches to a lock-free
+ * overflow list shared by all threads, and a thread whose cache runs dry takes a batch back from
+ * there before allocating. Only whole batches move between threads, so the shared list is
+ * touched once per kBatchNodes nodes.
+ *
+ * Nodes never move between threads while alive: only pooled nodes do, and init() resets them.
+ *
+ * With HugePages enabled, new nodes come from its arena rather than the heap. Those can't be
+ * freed, so trimming leaves them pooled.
+ */
+template<class Node>
+class NodePool {
+public:
+	/**
+	 * A pooled node initialized with @p args, or a new one when no thread has any to spare.
+	 */
+	template<class... Args>
+	static Node* allocate(Args... args) {
+		Cache& cache = sCache;
+		if(cache.nodes.empty()) {
+			refill(cache);
+		}
+		if(!cache.nodes.empty()) {
+			Node* node = cache.nodes.back();
+			cache.nodes.pop_back();
+			node->init(args...);
+			return node;
+		}
+		
+		void* memory = HugePages::allocateNode(sizeof(Node), alignof(Node));
+		Node* node = memory ? new(memory) Node(args...) : new Node(args...);
+		if(++cache.held > cache.highWater) {
+			cache.highWater = cache.held;
+		}
+		return node;
+	}
+	
+	static void deallocate(Node* node) {
+		Cache& cache = sCache;
+		cache.nodes.push_back(node);
+		if(cache.nodes.size() >= kCacheLimit) {
+			overflow(cache, kBatchNodes);
+		}
+	}
+	
+	/**
+	 * Nodes this thread holds, alive or pooled, now and at most.
+	 */
+	static size_t getHeldCount() {
+		return sCache.held;
+	}
+	
+	static size_t getHighWaterCount() {
+		return sCache.highWater;
+	}
+	
+	/**
+	 * Free this thread's pooled nodes until at most @p keep are left, along with every node
+	 * waiting in the shared overflow, since no thread is holding those. Arena nodes stay.
+	 */
+	static void trim(size_t keep) {
+		Cache& cache = sCache;
+		std::vector<Node*> arenaNodes;
+		while(cache.nodes.size() > keep) {
+			Node* node = cache.nodes.back();
+			cache.nodes.pop_back();
+			if(HugePages::isArenaNode(node)) {
+				arenaNodes.push_back(node);
+			}
+			else {
+				delete node;
+				--cache.held;
+			}
+		}
+		while(Batch* batch = sFull.pop()) {
+			for(size_t i = 0; i < batch->count; i++) {
+				if(HugePages::isArenaNode(batch->nodes[i])) {
+					arenaNodes.push_back(batch->nodes[i]);
+					++cache.held;
+				}
+				else {
+					delete batch->nodes[i];
+				}
+			}
+			sSpare.push(batch);
+		}
+		cache.nodes.insert(cache.nodes.end(), arenaNodes.begin(), arenaNodes.end());
+	}
+
+private:
+	static const size_t kBatchNodes = 256;
+	static const size_t kCacheLimit = 16 * kBatchNodes;
+	
+	/**
+	 * A batch of nodes on its way between threads. Batches are never freed, only reused through
+	 * sSpare, so a thread can always safely read one another thread has just popped.
+	 */
+	struct Batch {
+		std::atomic<Batch*> next;
+		size_t count;
+		Node* nodes[kBatchNodes];
+	};
+	
+	/**
+	 * Treiber stack of batches. The head carries a tag that changes with every push and pop, so
+	 * a pop that read a batch's next pointer before other threads popped and pushed the same
+	 * batch again fails its CAS instead of linking in a stale batch (the ABA problem). Pointers
+	 * are taken to fit in the low 48 bits, as user space addresses do on x86-64 and ARM64.
+	 */
+	class BatchStack {
+	public:
+		// Constant initialized, so it's usable before any dynamic initialization runs
+		constexpr BatchStack()
+		: mHead(0) { }
+		
+		void push(Batch* batch) {
+			uint64_t head = mHead.load(std::memory_order_relaxed);
+			do {
+				batch->next.store(pointerOf(head), std::memory_order_relaxed);
+			} while(!mHead.compare_exchange_weak(head, tagging(batch, head), std::memory_order_release, std::memory_order_relaxed));
+		}
+		
+		Batch* pop() {
+			uint64_t head = mHead.load(std::memory_order_acquire);
+			while(Batch* batch = pointerOf(head)) {
+				Batch* next = batch->next.load(std::memory_order_relaxed);
+				if(mHead.compare_exchange_weak(head, tagging(next, head), std::memory_order_acquire, std::memory_order_acquire)) {
+					return batch;
+				}
+			}
+			return nullptr;
+		}
+	
+	private:
+		static const uint64_t kPointerMask = (1ull << 48) - 1;
+		
+		static Batch* pointerOf(uint64_t head) {
+			return (Batch*)(uintptr_t)(head & kPointerMask);
+		}
+		
+		static uint64_t tagging(Batch* batch, uint64_t oldHead) {
+			return (uint64_t)(uintptr_t)batch | ((oldHead & ~kPointerMask) + (kPointerMask + 1));
+		}
+		
+		std::atomic<uint64_t> mHead;
+	};
+	
+	struct Cache {
+		Cache()
+		: held(0), highWater(0) { }
+		
+		// A thread's pooled nodes outlive it, for whichever thread allocates next
+		~Cache() {
+			while(!nodes.empty()) {
+				overflow(*this, nodes.size() < kBatchNodes ? nodes.size() : kBatchNodes);
+			}
+		}
+		
+		std::vector<Node*> nodes;
+		size_t held;
+		size_t highWater;
+	};
+	
+	static void overflow(Cache& cache, size_t count) {
+		Batch* batch = sSpare.pop();
+		if(!batch) {
+			batch = new Batch;
+		}
+		batch->count = count;
+		for(size_t i = 0; i < count; i++) {
+			batch->nodes[i] = cache.nodes.back();
+			cache.nodes.pop_back();
+		}
+		cache.held -= count;
+		sFull.push(batch);
+	}
+	
+	static void refill(Cache& cache) {
+		Batch* batch = sFull.pop();
+		if(!batch) {
+			return;
+		}
+		cache.nodes.insert(cache.nodes.end(), batch->nodes, batch->nodes + batch->count);
+		cache.held += batch->count;
+		if(cache.held > cache.highWater) {
+			cache.highWater = cache.held;
+		}
+		sSpare.push(batch);
+	}
+	
+	static thread_local Cache sCache;
+	static BatchStack sFull;
+	static BatchStack sSpare;
+};
+
+template<class Node>
+thread_local typename NodePool<Node>::Cache NodePool<Node>::sCache;
+
+template<class Node>
+typename NodePool<Node>::BatchStack NodePool<Node>::sFull;
+
+template<class Node>
+typename NodePool<Node>::BatchStack NodePool<Node>::sSpare;
+
+#endif /* MM_NODEPOOL_H */
@@ -0,0 +1,184 @@
+//
+//  NodeTable.h
+//  CAP4053_Minimax
+//
+//  Created by kTeam on 10/19/26.
+//  Copyright © 2026 kTeam. All rights reserved.
+//
+
+#ifndef MM_NODETABLE_H
+#define MM_NODETABLE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Live tree nodes of one type by grid, so every path that reaches the same board shares one node
+ * and its subtree. Nodes add themselves when they're created and remove themselves when their
+ * last reference is released.
+ *
+ * Every node creation and release goes through here, so it's an open addressing table with
+ * linear probing rather than a node-based map: lookups touch one or two cache lines and nothing
+ * is allocated except when the table grows.
+ */
+template<class Grid, class Node>
+class NodeTable {
+public:
+	NodeTable()
+	: mMask(0), mCount(0), mHighWaterSlots(0) { }
+	
+	Node* find(Grid grid) const {
+		if(mSlots.empty()) {
+			return nullptr;
+		}
+		for(size_t i = hashing(grid) & mMask; mSlots[i].node; i = (i + 1) & mMask) {
+			if(mSlots[i].grid == grid) {
+				return mSlots[i].node;
+			}
+		}
+		return nullptr;
+	}
+	
+	/**
+	 * Start loading the slot find() or insert() of @p grid starts probing at.
+	 */
+	void prefetch(Grid grid) const {
+		if(!mSlots.empty()) {
+			__builtin_prefetch(&mSlots[hashing(grid) & mMask]);
+		}
+	}
+	
+	/**
+	 * Add @p node, whose grid must not be in the table yet.
+	 */
+	void insert(Grid grid, Node* node) {
+		// Keep at most half the slots full so probe sequences stay short
+		if(2 * (mCount + 1) > mSlots.size()) {
+			rehashing(mSlots.size() ? 2 * mSlots.size() : kMinimumSlots);
+		}
+		size_t i = hashing(grid) & mMask;
+		while(mSlots[i].node) {
+			i = (i + 1) & mMask;
+		}
+		mSlots[i].grid = grid;
+		mSlots[i].node = node;
+		++mCount;
+	}
+	
+	void erase(Grid grid) {
+		if(mSlots.empty()) {
+			return;
+		}
+		size_t i = hashing(grid) & mMask;
+		while(mSlots[i].node && mSlots[i].grid != grid) {
+			i = (i + 1) & mMask;
+		}
+		if(!mSlots[i].node) {
+			return;
+		}
+		
+		// Shift later entries of the probe sequence back into the hole instead of leaving a
+		// tombstone, so lookups never slow down as nodes come and go
+		size_t hole = i;
+		for(size_t j = (i + 1) & mMask; mSlots[j].node; j = (j + 1) & mMask) {
+			size_t home = hashing(mSlots[j].grid) & mMask;
+			if(((j - home) & mMask) >= ((j - hole) & mMask)) {
+				mSlots[hole] = mSlots[j];
+				hole = j;
+			}
+		}
+		mSlots[hole].node = nullptr;
+		--mCount;
+	}
+	
+	size_t size() const {
+		return mCount;
+	}
+	
+	/**
+	 * Give back the slots once the nodes fill an eighth of them or less, keeping them a quarter
+	 * full so the table doesn't grow again right away, or all of them if there are no nodes.
+	 */
+	void shrink() {
+		if(mCount == 0) {
+			std::vector<Slot>().swap(mSlots);
+			mMask = 0;
+			return;
+		}
+		if(8 * mCount > mSlots.size()) {
+			return;
+		}
+		size_t slots = kMinimumSlots;
+		while(slots < 4 * mCount) {
+			slots *= 2;
+		}
+		if(slots < mSlots.size()) {
+			rehashing(slots);
+		}
+	}
+	
+	/**
+	 * Bytes of the slots, now and at most.
+	 */
+	size_t getSlotBytes() const {
+		return mSlots.size() * sizeof(Slot);
+	}
+	
+	size_t getHighWaterSlotBytes() const {
+		return mHighWaterSlots * sizeof(Slot);
+	}
+	
+	/**
+	 * Call @p visit with every node. It must not add or remove nodes.
+	 */
+	template<class Visitor>
+	void forEach(Visitor visit) const {
+		for(const Slot& slot : mSlots) {
+			if(slot.node) {
+				visit(slot.node);
+			}
+		}
+	}
+
+private:
+	struct Slot {
+		Grid grid;
+		Node* node;
+	};
+	
+	static const size_t kMinimumSlots = 1024;
+	
+	static size_t hashing(Grid grid) {
+		// Fold wide grids into 64 bits (the double shift is zero for 64-bit grids), then mix,
+		// since sibling grids differ in only a nybble or two
+		uint64_t hash = (uint64_t)grid ^ (uint64_t)(grid >> 32 >> 32);
+		hash ^= hash >> 29;
+		hash *= 0xbf58476d1ce4e5b9;
+		hash ^= hash >> 32;
+		return (size_t)hash;
+	}
+	
+	/**
+	 * Move every node into @p slots new slots, a power of two.
+	 */
+	void rehashing(size_t slots) {
+		std::vector<Slot> old(slots);
+		old.swap(mSlots);
+		mMask = mSlots.size() - 1;
+		mHighWaterSlots = std::max(mHighWaterSlots, mSlots.size());
+		mCount = 0;
+		for(const Slot& slot : old) {
+			if(slot.node) {
+				insert(slot.grid, slot.node);
+			}
+		}
+	}
+	
+	std::vector<Slot> mSlots;
+	size_t mMask;
+	size_t mCount;
+	size_t mHighWaterSlots;
+};
+
+#endif /* MM_NODETABLE_H */
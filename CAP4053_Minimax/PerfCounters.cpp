@@ -0,0 +1,200 @@
+//
+//  PerfCounters.cpp
+//  CAP4053_Minimax
+//
+//  Created by kTeam on 10/19/26.
+//  Copyright © 2026 kTeam. All rights reserved.
+//
+
+#include "PerfCounters.h"
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+
+static const char* const kEventNames[] = {
+	"cycles", "instructions", "cache misses", "branch misses", "dTLB misses", "task clock"
+};
+
+
+/**
+ * snprintf() onto the end of the @p *length characters already in @p out.
+ */
+static void appending(char* out, size_t size, int* length, const char* format, ...) {
+	va_list args;
+	va_start(args, format);
+	bool room = (size_t)*length < size;
+	int written = vsnprintf(room ? out + *length : nullptr, room ? size - *length : 0, format, args);
+	va_end(args);
+	if(written > 0) {
+		*length += written;
+	}
+}
+
+
+PerfCounters::Sample::Sample()
+: enabled(0), running(0), counted(0) {
+	memset(values, 0, sizeof(values));
+}
+
+
+PerfCounters::Sample PerfCounters::Sample::operator-(const Sample& start) const {
+	// Scaling each read by its own share of the time and subtracting would mix two different
+	// shares, so scale the difference by the share of this window alone
+	Sample ret;
+	uint64_t enabledTime = enabled - start.enabled, runningTime = running - start.running;
+	if(runningTime == 0) {
+		return ret;
+	}
+	for(int i = 0; i < kEventCount; i++) {
+		uint64_t value = values[i] - start.values[i];
+		if(runningTime < enabledTime) {
+			value = (uint64_t)((double)value * enabledTime / runningTime);
+		}
+		ret.values[i] = value;
+	}
+	ret.enabled = ret.running = enabledTime;
+	ret.counted = counted & start.counted;
+	return ret;
+}
+
+
+PerfCounters::Sample& PerfCounters::Sample::operator+=(const Sample& other) {
+	// An empty sample takes on whatever the first one added counts
+	counted = counted ? counted & other.counted : other.counted;
+	for(int i = 0; i < kEventCount; i++) {
+		values[i] += other.values[i];
+	}
+	enabled += other.enabled;
+	running += other.running;
+	return *this;
+}
+
+
+bool PerfCounters::Sample::isCounted(Event event) const {
+	return (counted >> event) & 1;
+}
+
+
+std::unique_ptr<PerfCounters> PerfCounters::open() {
+#ifdef __linux__
+	static const struct {
+		uint32_t type;
+		uint64_t config;
+	} kEvents[] = {
+		{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+		{PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+		{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+		{PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+		{PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+		{PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK}
+	};
+	
+	// The first event that opens leads the group, and starts disabled so every member starts
+	// counting at once
+	int leader = -1;
+	std::vector<int> fds;
+	std::vector<Event> events;
+	for(int i = 0; i < kEventCount; i++) {
+		perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = kEvents[i].type;
+		attr.config = kEvents[i].config;
+		attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		attr.disabled = leader < 0;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+		if(fd < 0) {
+			continue;
+		}
+		if(leader < 0) {
+			leader = fd;
+		}
+		fds.push_back(fd);
+		events.push_back((Event)i);
+	}
+	if(leader < 0) {
+		return nullptr;
+	}
+	
+	ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	return std::unique_ptr<PerfCounters>(new PerfCounters(leader, fds, events));
+#else
+	return nullptr;
+#endif
+}
+
+
+PerfCounters::PerfCounters(int leader, const std::vector<int>& fds, const std::vector<Event>& events)
+: mLeader(leader), mFds(fds), mEvents(events), mCounted(0) {
+	for(Event event : events) {
+		mCounted |= 1u << event;
+	}
+}
+
+
+PerfCounters::~PerfCounters() {
+	// Members go before the leader
+	for(size_t i = mFds.size(); i-- > 0;) {
+		close(mFds[i]);
+	}
+}
+
+
+PerfCounters::Sample PerfCounters::read() const {
+	// The group reads as its size, the times it was enabled and running, then each value
+	uint64_t data[3 + kEventCount];
+	Sample ret;
+	ssize_t bytes = ::read(mLeader, data, sizeof(data));
+	if(bytes < (ssize_t)(3 * sizeof(uint64_t)) || data[0] != mEvents.size()) {
+		return ret;
+	}
+	
+	ret.enabled = data[1];
+	ret.running = data[2];
+	for(size_t i = 0; i < mEvents.size(); i++) {
+		ret.values[mEvents[i]] = data[3 + i];
+	}
+	ret.counted = mCounted;
+	return ret;
+}
+
+
+bool PerfCounters::isCounted(Event event) const {
+	return (mCounted >> event) & 1;
+}
+
+
+const char* PerfCounters::getName(Event event) {
+	return kEventNames[event];
+}
+
+
+int PerfCounters::format(char* out, size_t size, const Sample& counts, double units, const char* unit) {
+	int length = 0;
+	if(size) {
+		out[0] = '\0';
+	}
+	if(counts.isCounted(CYCLES) && counts.isCounted(INSTRUCTIONS) && counts.values[CYCLES]) {
+		appending(out, size, &length, "IPC %.2f", (double)counts.values[INSTRUCTIONS] / counts.values[CYCLES]);
+	}
+	for(Event event : {CACHE_MISSES, BRANCH_MISSES, DTLB_MISSES}) {
+		if(counts.isCounted(event)) {
+			appending(out, size, &length, "%s%.2f %s/%s", length ? ", " : "", counts.values[event] / units, getName(event), unit);
+		}
+	}
+	
+	// Without the hardware counters, CPU time is the best there is
+	if(!counts.isCounted(CYCLES) && counts.isCounted(TASK_CLOCK)) {
+		appending(out, size, &length, "%s%.1f ns CPU/%s", length ? ", " : "", counts.values[TASK_CLOCK] / units, unit);
+	}
+	return length;
+}
@@ -0,0 +1,95 @@
+//
+//  PerfCounters.h
+//  CAP4053_Minimax
+//
+//  Created by kTeam on 10/19/26.
+//  Copyright © 2026 kTeam. All rights reserved.
+//
+
+#ifndef MM_PERFCOUNTERS_H
+#define MM_PERFCOUNTERS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+
+/**
+ * Hardware counters of one thread through Linux's perf_event_open: cycles, instructions, cache
+ * misses, branch misses and dTLB load misses, along with the task clock. They're opened as one
+ * group, so they all count over exactly the same instructions and ratios like IPC are exact.
+ *
+ * Containers and VMs often don't expose the CPU's counters, and some CPUs lack some events.
+ * Whatever can't be opened is left out, so there the group may count nothing but the task
+ * clock, a software event every Linux kernel has, which still gives CPU time unaffected by
+ * preemption.
+ */
+class PerfCounters {
+public:
+	enum Event {
+		CYCLES, INSTRUCTIONS, CACHE_MISSES, BRANCH_MISSES, DTLB_MISSES, TASK_CLOCK, kEventCount
+	};
+	
+	/**
+	 * Raw counts since the group was opened, or estimates between two reads when subtracted.
+	 * Events the group doesn't count read as zero and are left out of @p counted.
+	 */
+	struct Sample {
+		Sample();
+		
+		/**
+		 * Counts between @p start and this read, scaled up for the part of that time the group
+		 * wasn't running. Nothing is counted if it didn't run at all.
+		 */
+		Sample operator-(const Sample& start) const;
+		Sample& operator+=(const Sample& other);
+		bool isCounted(Event event) const;
+		
+		uint64_t values[kEventCount];
+		
+		// Nanoseconds the group was enabled and actually counting. Other users of the counters
+		// can force it to take turns with them.
+		uint64_t enabled;
+		uint64_t running;
+		uint32_t counted;
+	};
+	
+	/**
+	 * Start counting for the calling thread. Only that thread is counted, so open the counters on
+	 * the thread doing the work.
+	 * @return The counters, or nullptr if no event can be counted at all, say off Linux or with
+	 * perf_event_open forbidden
+	 */
+	static std::unique_ptr<PerfCounters> open();
+	
+	~PerfCounters();
+	
+	/**
+	 * Counts so far, unscaled, so only the difference of two reads means anything.
+	 */
+	Sample read() const;
+	bool isCounted(Event event) const;
+	static const char* getName(Event event);
+	
+	/**
+	 * Describe @p counts spent on @p units units of work, named @p unit, as IPC and events per
+	 * unit, or as CPU time per unit where only the task clock is counted.
+	 * @return Characters written to @p out, like snprintf()
+	 */
+	static int format(char* out, size_t size, const Sample& counts, double units, const char* unit);
+
+private:
+	PerfCounters(int leader, const std::vector<int>& fds, const std::vector<Event>& events);
+	PerfCounters(const PerfCounters&);
+	PerfCounters& operator=(const PerfCounters&);
+	
+	int mLeader;
+	std::vector<int> mFds;
+	
+	// Events in the order the group reads them
+	std::vector<Event> mEvents;
+	uint32_t mCounted;
+};
+
+#endif /* MM_PERFCOUNTERS_H */
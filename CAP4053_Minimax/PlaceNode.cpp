@@ -8,128 +8,275 @@
 
 #include "PlaceNode.h"
 #include "ShiftNode.h"
+#include "BasicBoard.h"
 #include <climits>
 #include <cstring>
 
 
-std::queue<PlaceNode*> PlaceNode::sPool;
+// Each thread keeps its own table so searches on different threads never share live nodes
+template<class BoardType>
+thread_local NodeTable<typename BoardType::Grid, BasicPlaceNode<BoardType>> BasicPlaceNode<BoardType>::sTable;
 
+template<class BoardType>
+thread_local std::vector<BasicPlaceNode<BoardType>*> BasicPlaceNode<BoardType>::sDead;
 
-PlaceNode* PlaceNode::allocate(Board initBoard) {
-	if(!sPool.empty()) {
-		PlaceNode* ret = sPool.front();
-		sPool.pop();
-		ret->init(initBoard);
+
+template<class BoardType>
+BasicPlaceNode<BoardType>* BasicPlaceNode<BoardType>::acquire(BoardType board, int lineScore) {
+	BasicPlaceNode* ret = sTable.find(board.getCompressedGrid());
+	if(ret) {
+		ret->retain();
 		return ret;
 	}
 	
-	return new PlaceNode(initBoard);
+	ret = NodePool<BasicPlaceNode>::allocate(board, lineScore);
+	sTable.insert(board.getCompressedGrid(), ret);
+	return ret;
+}
+
+
+template<class BoardType>
+void BasicPlaceNode<BoardType>::prefetchAcquire(BoardType board) {
+	sTable.prefetch(board.getCompressedGrid());
+}
+
+
+template<class BoardType>
+size_t BasicPlaceNode<BoardType>::getLiveCount() {
+	return sTable.size();
+}
+
+
+template<class BoardType>
+size_t BasicPlaceNode<BoardType>::getAllocatedCount() {
+	return NodePool<BasicPlaceNode>::getHeldCount();
 }
 
 
-PlaceNode::PlaceNode(Board initBoard)
+template<class BoardType>
+size_t BasicPlaceNode<BoardType>::getHighWaterCount() {
+	return NodePool<BasicPlaceNode>::getHighWaterCount();
+}
+
+
+template<class BoardType>
+size_t BasicPlaceNode<BoardType>::getTableBytes() {
+	return sTable.getSlotBytes();
+}
+
+
+template<class BoardType>
+size_t BasicPlaceNode<BoardType>::getHighWaterTableBytes() {
+	return sTable.getHighWaterSlotBytes();
+}
+
+
+template<class BoardType>
+void BasicPlaceNode<BoardType>::shrinkTable() {
+	sTable.shrink();
+}
+
+
+template<class BoardType>
+void BasicPlaceNode<BoardType>::trimPool(size_t keep) {
+	NodePool<BasicPlaceNode>::trim(keep);
+}
+
+
+template<class BoardType>
+size_t BasicPlaceNode<BoardType>::reclaim(size_t nodes) {
+	size_t freed = 0;
+	while(freed < nodes && !sDead.empty()) {
+		BasicPlaceNode* node = sDead.back();
+		sDead.pop_back();
+		
+		// Children only ever exist for holes
+		for(uint32_t holes = node->mBoard.holeMask(); holes; holes &= holes - 1) {
+			ShiftNodeType** children = node->mChildren[__builtin_ctz(holes)];
+			for(int j = 0; j < 2; j++) {
+				if(children[j]) {
+					children[j]->release();
+				}
+			}
+		}
+		NodePool<BasicPlaceNode>::deallocate(node);
+		++freed;
+	}
+	return freed;
+}
+
+
+template<class BoardType>
+size_t BasicPlaceNode<BoardType>::getDeadCount() {
+	return sDead.size();
+}
+
+
+template<class BoardType>
+BasicPlaceNode<BoardType>::BasicPlaceNode(BoardType initBoard, int lineScore)
 : mBoard(initBoard) {
-	init(initBoard);
+	init(initBoard, lineScore);
 }
 
 
-void PlaceNode::init(Board initBoard) {
+template<class BoardType>
+void BasicPlaceNode<BoardType>::init(BoardType initBoard, int lineScore) {
 	mBoard = initBoard;
+	mLineScore = lineScore;
+	mReferences = 1;
+	mBounds.reset();
 	memset(mChildren, 0, sizeof(mChildren));
 }
 
 
-void PlaceNode::deallocate() {
-	sPool.push(this);
+template<class BoardType>
+void BasicPlaceNode<BoardType>::retain() {
+	++mReferences;
 }
 
 
-ShiftNode* PlaceNode::getChild(unsigned row, unsigned col, Tile tile) {
-	bool hasChild = false;
-	for(int i = 0; i < 16; i++) {
-		for(int j = 0; j < 2; j++) {
-			if(mChildren[i][j]) {
-				hasChild = true;
-			}
-		}
+template<class BoardType>
+void BasicPlaceNode<BoardType>::release() {
+	if(--mReferences != 0) {
+		return;
 	}
 	
-	if(!hasChild) {
-		populateChildren();
+	sTable.erase(mBoard.getCompressedGrid());
+	sDead.push_back(this);
+}
+
+
+template<class BoardType>
+void BasicPlaceNode<BoardType>::prefetch() const {
+	// The children come first but only the holes' are read, so start with the fields after them
+	__builtin_prefetch(&mBoard);
+	__builtin_prefetch(&mBounds);
+}
+
+
+template<class BoardType>
+typename BasicPlaceNode<BoardType>::ShiftNodeType* BasicPlaceNode<BoardType>::getChild(unsigned row, unsigned col, Tile tile) {
+	populateIfNeeded();
+	return mChildren[row * BoardType::kSize + col][tile-1];
+}
+
+
+template<class BoardType>
+void BasicPlaceNode<BoardType>::populateChildren() {
+	BoardType children[kCellCount * 2];
+	unsigned count = 2 * mBoard.allPlaces(children);
+	
+	// Start every child's lookups before waiting on the first, rather than missing once per
+	// child in turn
+	for(unsigned i = 0; i < count; i++) {
+		ShiftNodeType::prefetchAcquire(children[i]);
 	}
 	
-	return mChildren[row * 4 + col][tile-1];
+	// allPlaces() wrote two boards per hole, in the same order as the hole mask. Each placement
+	// changes one row and one column, so the children's line scores are cheap to update.
+	BoardType* child = children;
+	for(uint32_t holes = mBoard.holeMask(); holes; holes &= holes - 1) {
+		unsigned cell = __builtin_ctz(holes);
+		for(int j = 0; j < 2; j++, child++) {
+			mChildren[cell][j] = ShiftNodeType::acquire(*child, mBoard.updatedLineScore(mLineScore, *child));
+		}
+	}
 }
 
 
-void PlaceNode::prune(ShiftNode* newHead) {
-	for(int i = 0; i < 16; i++) {
-		for(int j = 0; j < 2; j++) {
-			if(mChildren[i][j]) {
-				mChildren[i][j]->prune(newHead);
-				if(mChildren[i][j] != newHead) {
-					mChildren[i][j]->deallocate();
-					mChildren[i][j] = nullptr;
-				}
-			}
-		}
+template<class BoardType>
+void BasicPlaceNode<BoardType>::populateIfNeeded() {
+	// Children are created for every hole at once, so checking the first hole is enough
+	uint32_t holes = mBoard.holeMask();
+	if(holes && !mChildren[__builtin_ctz(holes)][0]) {
+		populateChildren();
 	}
 }
 
 
-void PlaceNode::populateChildren() {
-	Board children[32];
-	mBoard.allPlaces(children);
-	
-	Board* child = children;
-	for(int i = 0; i < 16; i++) {
-		for(int j = 0; j < 2; j++) {
-			if(child->isEmpty()) {
-				++child;
-				continue;
-			}
-			
-			mChildren[i][j] = ShiftNode::allocate(*child++);
-		}
+template<class BoardType>
+void BasicPlaceNode<BoardType>::prefetchChild(const ShiftNodeType* child, const BoardType* board) {
+	child->prefetch();
+	if(board) {
+		ShiftNodeType::prefetchProbe(*board);
 	}
 }
 
 
-int PlaceNode::getMinScore(unsigned depth, int alpha, int beta) {
+template<class BoardType>
+int BasicPlaceNode<BoardType>::getMinScore(unsigned depth, int alpha, int beta, SearchBudget& budget, bool nullWindows) {
+	if(!budget.spending()) {
+		return 0;
+	}
+	
 	if(depth == 0) {
-		return mBoard.estimateScore();
+		return mBoard.estimateScore(mLineScore);
 	}
 	
 	int score, minScore = INT_MAX;
-	bool hasChild = false;
+	if(mBounds.probing(depth, alpha, beta, &score)) {
+		return score;
+	}
+	int origAlpha = alpha, origBeta = beta;
+	populateIfNeeded();
 	
-hereIAmOnceAgain:
-	for(int i = 0; i < 16; i++) {
-		for(int j = 0; j < 2; j++) {
-			if(mChildren[i][j]) {
-				hasChild = true;
-				
-				// Intentionally not decrementing depth here
-				score = mChildren[i][j]->getMaxScore(depth, alpha, beta);
-				if(score < minScore) {
-					minScore = score;
-				}
-				if(minScore < beta) {
-					beta = minScore;
-				}
-				if(alpha >= beta) {
-					return minScore;
-				}
+	// Only visit the holes rather than every cell. Children are listed in search order so the
+	// next few can be on their way while one is searched; prefetching all of them would spend
+	// bandwidth on siblings a cutoff never reaches.
+	ShiftNodeType* children[kCellCount * 2];
+	unsigned count = 0;
+	for(uint32_t holes = mBoard.holeMask(); holes; holes &= holes - 1) {
+		ShiftNodeType** cellChildren = mChildren[__builtin_ctz(holes)];
+		children[count++] = cellChildren[0];
+		children[count++] = cellChildren[1];
+	}
+	
+	// A child's search probes the score cache for its board. Making the boards again is cheaper
+	// than reading them out of the children, which would wait on each child's miss.
+	BoardType boards[kCellCount * 2];
+	bool probing = ShiftNodeType::getScoreCache() != nullptr;
+	if(probing) {
+		mBoard.allPlaces(boards);
+	}
+	for(unsigned i = 0; i < count && i < kPrefetchDistance; i++) {
+		prefetchChild(children[i], probing ? &boards[i] : nullptr);
+	}
+	
+	for(unsigned i = 0; i < count; i++) {
+		if(i + kPrefetchDistance < count) {
+			prefetchChild(children[i + kPrefetchDistance], probing ? &boards[i + kPrefetchDistance] : nullptr);
+		}
+		
+		// Intentionally not decrementing depth here
+		if(nullWindows && i != 0) {
+			// Mirror of the shift node: prove the placement no worse than beta before a full search
+			score = children[i]->getMaxScore(depth, beta - 1, beta, budget, true);
+			if(score < beta && score > alpha) {
+				score = children[i]->getMaxScore(depth, alpha, beta, budget, true);
 			}
 		}
+		else {
+			score = children[i]->getMaxScore(depth, alpha, beta, budget, nullWindows);
+		}
+		if(score < minScore) {
+			minScore = score;
+		}
+		if(minScore < beta) {
+			beta = minScore;
+		}
+		if(alpha >= beta) {
+			break;
+		}
 	}
 	
-	// No children? Probably need to populate children and try again
-	if(!hasChild) {
-		hasChild = true;
-		populateChildren();
-		goto hereIAmOnceAgain;
+	// A search cut short by the budget returns garbage, which mustn't outlive it
+	if(!budget.isExhausted()) {
+		mBounds.store(depth, origAlpha, origBeta, minScore);
 	}
-	
 	return minScore;
 }
+
+
+template class BasicPlaceNode<Board>;
+template class BasicPlaceNode<BasicBoard<4, 5>>;
+template class BasicPlaceNode<BasicBoard<5, 4>>;
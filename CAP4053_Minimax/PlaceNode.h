@@ -9,31 +9,110 @@
 #ifndef MM_PLACENODE_H
 #define MM_PLACENODE_H
 
-#include <queue>
+#include <vector>
 #include "Board.h"
+#include "NodePool.h"
+#include "NodeBounds.h"
+#include "NodeTable.h"
+#include "SearchBudget.h"
 
-class ShiftNode;
+template<class BoardType>
+class BasicShiftNode;
 
-// This represents a minimizing node
-class PlaceNode {
+// This represents a minimizing node, shared and reference counted like BasicShiftNode
+template<class BoardType>
+class BasicPlaceNode {
 public:
-	static PlaceNode* allocate(Board initBoard);
+	typedef BasicShiftNode<BoardType> ShiftNodeType;
 	
-	PlaceNode(Board initBoard);
-	void init(Board initBoard);
-	void deallocate();
+	/**
+	 * The node for @p board, shared with any other holder of it on this thread.
+	 * @return A node with a reference held for the caller
+	 */
+	static BasicPlaceNode* acquire(BoardType board, int lineScore);
 	
-	ShiftNode* getChild(unsigned row, unsigned col, Tile tile);
-	void prune(ShiftNode* newHead);
-	int getMinScore(unsigned depth, int alpha, int beta);
+	/**
+	 * Start loading the slot acquire() of @p board looks up in this thread's table.
+	 */
+	static void prefetchAcquire(BoardType board);
 	
+	/**
+	 * Number of place nodes alive on this thread.
+	 */
+	static size_t getLiveCount();
+	
+	/**
+	 * Place nodes this thread holds, alive or pooled, now and at most.
+	 */
+	static size_t getAllocatedCount();
+	static size_t getHighWaterCount();
+	
+	/**
+	 * Bytes of this thread's table of live place nodes, now and at most.
+	 */
+	static size_t getTableBytes();
+	static size_t getHighWaterTableBytes();
+	
+	/**
+	 * Give back table slots left empty by freed nodes. See NodeTable::shrink().
+	 */
+	static void shrinkTable();
+	
+	/**
+	 * Free this thread's pooled nodes until at most @p keep are left, and the ones other
+	 * threads gave up.
+	 */
+	static void trimPool(size_t keep);
+	
+	/**
+	 * Finish freeing up to @p nodes nodes whose last reference is gone, releasing their children.
+	 * Children that lose their last reference are queued in turn rather than freed at once.
+	 * @return Number of nodes freed
+	 */
+	static size_t reclaim(size_t nodes);
+	static size_t getDeadCount();
+	
+	BasicPlaceNode(BoardType initBoard, int lineScore);
+	void init(BoardType initBoard, int lineScore);
+	void retain();
+	
+	/**
+	 * Drop a reference. The last one unshares the node and queues it for reclaim().
+	 */
+	void release();
+	
+	/**
+	 * Start loading the fields a search reads first.
+	 */
+	void prefetch() const;
+	
+	ShiftNodeType* getChild(unsigned row, unsigned col, Tile tile);
+	int getMinScore(unsigned depth, int alpha, int beta, SearchBudget& budget, bool nullWindows);
+
 private:
 	void populateChildren();
+	void populateIfNeeded();
+	
+	/**
+	 * Start loading @p child and, given its @p board, the score cache entry its search probes.
+	 */
+	static void prefetchChild(const ShiftNodeType* child, const BoardType* board);
 	
-	static std::queue<PlaceNode*> sPool;
+	static const unsigned kCellCount = BoardType::kSize * BoardType::kSize;
+	static const unsigned kPrefetchDistance = 4;
 	
-	ShiftNode* mChildren[16][2];
-	Board mBoard;
+	static thread_local NodeTable<typename BoardType::Grid, BasicPlaceNode> sTable;
+	static thread_local std::vector<BasicPlaceNode*> sDead;
+	
+	ShiftNodeType* mChildren[kCellCount][2];
+	BoardType mBoard;
+	uint32_t mReferences;
+	
+	// Cached BoardType::lineScore(), kept up to date incrementally from the parent
+	int mLineScore;
+	NodeBounds mBounds;
 };
 
+typedef BasicPlaceNode<Board> PlaceNode;
+
 #endif /* MM_PLACENODE_H */
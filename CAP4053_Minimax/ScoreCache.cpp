@@ -0,0 +1,219 @@
+//
+//  ScoreCache.cpp
+//  CAP4053_Minimax
+//
+//  Created by kTeam on 10/19/26.
+//  Copyright © 2026 kTeam. All rights reserved.
+//
+
+#include "ScoreCache.h"
+#include "HugePages.h"
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+/*
+ * The file layout is fixed: one page holding the header, followed by the entry array. All
+ * fields are stored in native byte order, which is the same on every machine we run on.
+ */
+struct CacheHeader {
+	char magic[8];
+	uint32_t formatVersion;
+	uint32_t entrySize;
+	uint64_t heuristic;
+	uint64_t capacity;
+	uint64_t checksum;
+};
+
+const uint32_t ScoreCache::kFormatVersion = 1;
+
+static const char kMagic[8] = {'M', 'M', 'S', 'C', 'O', 'R', 'E', '\0'};
+static const size_t kHeaderSize = 4096;
+
+#define DATA_VALID        ((uint64_t)1 << 63)
+#define MAKE_DATA(score, depth, bound) \
+	(DATA_VALID | ((uint64_t)(bound) << 40) | ((uint64_t)((depth) & 0xff) << 32) | (uint32_t)(score))
+#define DATA_SCORE(data)  ((int)(int32_t)(uint32_t)(data))
+#define DATA_DEPTH(data)  ((unsigned)(((data) >> 32) & 0xff))
+#define DATA_BOUND(data)  ((ScoreCache::Bound)(((data) >> 40) & 0x3))
+
+
+static uint64_t checksumHeader(const void* header) {
+	// FNV-1a over every field before the checksum itself
+	const uint8_t* bytes = (const uint8_t*)header;
+	uint64_t hash = 0xcbf29ce484222325;
+	for(size_t i = 0; i < offsetof(CacheHeader, checksum); i++) {
+		hash = (hash ^ bytes[i]) * 0x100000001b3;
+	}
+	return hash;
+}
+
+
+static inline uint64_t hashGrid(CompressedGrid grid) {
+	grid ^= grid >> 29;
+	grid *= 0xbf58476d1ce4e5b9;
+	grid ^= grid >> 32;
+	return grid;
+}
+
+
+std::unique_ptr<ScoreCache> ScoreCache::open(const char* path, size_t capacity, uint64_t heuristic) {
+	// Round capacity up to a power of two so the slot can be picked with a mask
+	uint64_t entries = 1;
+	while(entries < capacity) {
+		entries <<= 1;
+	}
+	size_t mapSize = kHeaderSize + entries * sizeof(Entry);
+	
+	int fd = ::open(path, O_RDWR | O_CREAT, 0644);
+	if(fd < 0) {
+		std::cerr << "Failed to open score cache " << path << ": " << strerror(errno) << std::endl;
+		return nullptr;
+	}
+	
+	// Check whether the existing file can be reused before mapping it
+	CacheHeader header;
+	bool valid = pread(fd, &header, sizeof(header), 0) == sizeof(header) &&
+		memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+		header.formatVersion == kFormatVersion &&
+		header.entrySize == sizeof(Entry) &&
+		header.heuristic == heuristic &&
+		header.capacity == entries &&
+		header.checksum == checksumHeader(&header);
+	
+	struct stat st;
+	if(valid && (fstat(fd, &st) != 0 || (size_t)st.st_size != mapSize)) {
+		valid = false;
+	}
+	
+	if(!valid) {
+		// Throw away the old contents. Truncating to zero first makes every entry read as empty.
+		if(ftruncate(fd, 0) != 0 || ftruncate(fd, mapSize) != 0) {
+			std::cerr << "Failed to size score cache " << path << ": " << strerror(errno) << std::endl;
+			close(fd);
+			return nullptr;
+		}
+	}
+	
+	void* map = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if(map == MAP_FAILED) {
+		std::cerr << "Failed to map score cache " << path << ": " << strerror(errno) << std::endl;
+		close(fd);
+		return nullptr;
+	}
+	if(HugePages::isEnabled()) {
+		HugePages::advise(map, mapSize);
+	}
+	
+	if(!valid) {
+		// The checksum is written last and flushed, so a crash here leaves an invalid header
+		CacheHeader* newHeader = (CacheHeader*)map;
+		memcpy(newHeader->magic, kMagic, sizeof(kMagic));
+		newHeader->formatVersion = kFormatVersion;
+		newHeader->entrySize = sizeof(Entry);
+		newHeader->heuristic = heuristic;
+		newHeader->capacity = entries;
+		newHeader->checksum = checksumHeader(newHeader);
+		msync(map, kHeaderSize, MS_SYNC);
+	}
+	
+	return std::unique_ptr<ScoreCache>(new ScoreCache(fd, map, mapSize));
+}
+
+
+ScoreCache::ScoreCache(int fd, void* map, size_t mapSize)
+: mFd(fd), mMap(map), mMapSize(mapSize), mEntries((Entry*)((char*)map + kHeaderSize)),
+  mMask((mapSize - kHeaderSize) / sizeof(Entry) - 1) {
+	static_assert(sizeof(Entry) == 16, "Cache entries must have a fixed layout");
+}
+
+
+ScoreCache::~ScoreCache() {
+	sync();
+	munmap(mMap, mMapSize);
+	close(mFd);
+}
+
+
+bool ScoreCache::probe(CompressedGrid grid, unsigned depth, int alpha, int beta, int* pScore) const {
+	const Entry& entry = mEntries[hashGrid(grid) & mMask];
+	uint64_t data = entry.data.load(std::memory_order_relaxed);
+	uint64_t check = entry.check.load(std::memory_order_relaxed);
+	
+	// Empty, torn, or belonging to another grid
+	if(!(data & DATA_VALID) || (check ^ data) != grid) {
+		return false;
+	}
+	
+	// Results of shallower searches aren't good enough
+	if(DATA_DEPTH(data) < depth) {
+		return false;
+	}
+	
+	int score = DATA_SCORE(data);
+	switch(DATA_BOUND(data)) {
+		case BOUND_EXACT:
+			break;
+		
+		case BOUND_LOWER:
+			if(score < beta) {
+				return false;
+			}
+			break;
+		
+		case BOUND_UPPER:
+			if(score > alpha) {
+				return false;
+			}
+			break;
+	}
+	
+	*pScore = score;
+	return true;
+}
+
+
+void ScoreCache::store(CompressedGrid grid, unsigned depth, int alpha, int beta, int score) {
+	Entry& entry = mEntries[hashGrid(grid) & mMask];
+	
+	// Don't replace a deeper result for the same grid
+	uint64_t old = entry.data.load(std::memory_order_relaxed);
+	if((old & DATA_VALID) && (entry.check.load(std::memory_order_relaxed) ^ old) == grid &&
+	   DATA_DEPTH(old) > depth
+	) {
+		return;
+	}
+	
+	Bound bound = BOUND_EXACT;
+	if(score <= alpha) {
+		bound = BOUND_UPPER;
+	}
+	else if(score >= beta) {
+		bound = BOUND_LOWER;
+	}
+	
+	uint64_t data = MAKE_DATA(score, depth, bound);
+	entry.data.store(data, std::memory_order_relaxed);
+	entry.check.store(grid ^ data, std::memory_order_relaxed);
+}
+
+
+void ScoreCache::prefetch(CompressedGrid grid) const {
+	__builtin_prefetch(&mEntries[hashGrid(grid) & mMask]);
+}
+
+
+void ScoreCache::sync() {
+	msync(mMap, mMapSize, MS_ASYNC);
+}
+
+
+size_t ScoreCache::getCapacity() const {
+	return mMask + 1;
+}
@@ -0,0 +1,118 @@
+//
+//  ScoreCache.h
+//  CAP4053_Minimax
+//
+//  Created by kTeam on 10/19/26.
+//  Copyright © 2026 kTeam. All rights reserved.
+//
+
+#ifndef MM_SCORECACHE_H
+#define MM_SCORECACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "Board.h"
+
+
+/**
+ * Memory-mapped cache from CompressedGrid to the score found by a search of a given depth.
+ * The file survives process restarts so new processes start with the results of old ones.
+ *
+ * The file starts with a checksummed header which records the heuristic it was built with.
+ * Each entry is stored as two words where one is the key XORed with the other, so an entry
+ * which was torn by a crash (or a racing writer) simply fails to match on the next probe.
+ */
+class ScoreCache {
+public:
+	enum Bound: uint8_t {
+		BOUND_EXACT, BOUND_LOWER, BOUND_UPPER
+	};
+	
+	/**
+	 * Open or create a cache file. If the existing file is damaged, has a different layout,
+	 * or was built with a different heuristic, it is reinitialized to an empty cache.
+	 * @param path Filesystem path of the cache file
+	 * @param capacity Number of entries, rounded up to a power of two
+	 * @param heuristic Version of the scoring heuristic, see Board::heuristicVersion()
+	 * @return The opened cache, or nullptr if the file couldn't be mapped
+	 */
+	static std::unique_ptr<ScoreCache> open(const char* path, size_t capacity, uint64_t heuristic);
+	
+	~ScoreCache();
+	
+	/**
+	 * Look up the score of a grid searched to at least the given depth.
+	 * @return True and the score in @p pScore when the cached result is usable in the window
+	 */
+	bool probe(CompressedGrid grid, unsigned depth, int alpha, int beta, int* pScore) const;
+	
+	/**
+	 * Record the result of searching a grid with the window (@p alpha, @p beta).
+	 */
+	void store(CompressedGrid grid, unsigned depth, int alpha, int beta, int score);
+	
+	/**
+	 * Start loading the entry of a grid that's about to be probed. The cache is far bigger than
+	 * any CPU cache, so a probe that waits for its entry almost always misses.
+	 */
+	void prefetch(CompressedGrid grid) const;
+	
+	/**
+	 * Schedule all dirty pages to be written back to the file.
+	 */
+	void sync();
+	
+	size_t getCapacity() const;
+
+private:
+	struct Entry {
+		std::atomic<uint64_t> check;
+		std::atomic<uint64_t> data;
+	};
+	
+	ScoreCache(int fd, void* map, size_t mapSize);
+	
+	static const uint32_t kFormatVersion;
+	
+	int mFd;
+	void* mMap;
+	size_t mMapSize;
+	Entry* mEntries;
+	uint64_t mMask;
+};
+
+
+/*
+ * Search helpers that probe and fill an optional cache. Cache entries are keyed by 64-bit grids,
+ * so only the specialized Board can use them and other board types never hit.
+ */
+template<class BoardType>
+inline bool probingCache(ScoreCache*, BoardType, unsigned, int, int, int*) {
+	return false;
+}
+
+inline bool probingCache(ScoreCache* cache, Board board, unsigned depth, int alpha, int beta, int* score) {
+	return cache && cache->probe(board.getCompressedGrid(), depth, alpha, beta, score);
+}
+
+template<class BoardType>
+inline void prefetchingCache(ScoreCache*, BoardType) { }
+
+inline void prefetchingCache(ScoreCache* cache, Board board) {
+	if(cache) {
+		cache->prefetch(board.getCompressedGrid());
+	}
+}
+
+template<class BoardType>
+inline void storingCache(ScoreCache*, BoardType, unsigned, int, int, int) { }
+
+inline void storingCache(ScoreCache* cache, Board board, unsigned depth, int alpha, int beta, int score) {
+	if(cache) {
+		cache->store(board.getCompressedGrid(), depth, alpha, beta, score);
+	}
+}
+
+#endif /* MM_SCORECACHE_H */
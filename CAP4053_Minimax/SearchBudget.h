@@ -0,0 +1,48 @@
+//
+//  SearchBudget.h
+//  CAP4053_Minimax
+//
+//  Created by kTeam on 10/19/26.
+//  Copyright © 2026 kTeam. All rights reserved.
+//
+
+#ifndef MM_SEARCHBUDGET_H
+#define MM_SEARCHBUDGET_H
+
+#include <cstdint>
+
+/**
+ * Counts the nodes a search visits against an optional limit. Once the limit is passed the
+ * budget stays exhausted, the engines unwind as fast as they can, and whatever they return
+ * must be thrown away.
+ */
+class SearchBudget {
+public:
+	static const uint64_t kUnlimited = UINT64_MAX;
+	
+	explicit SearchBudget(uint64_t limit = kUnlimited)
+	: mUsed(0), mLimit(limit) { }
+	
+	/**
+	 * Charge @p count nodes.
+	 * @return False if the budget is exhausted and the search should give up
+	 */
+	bool spending(uint64_t count = 1) {
+		mUsed += count;
+		return mUsed <= mLimit;
+	}
+	
+	bool isExhausted() const {
+		return mUsed > mLimit;
+	}
+	
+	uint64_t getUsed() const {
+		return mUsed;
+	}
+
+private:
+	uint64_t mUsed;
+	uint64_t mLimit;
+};
+
+#endif /* MM_SEARCHBUDGET_H */
@@ -0,0 +1,22 @@
+//
+//  SearchMode.h
+//  CAP4053_Minimax
+//
+//  Created by kTeam on 10/19/26.
+//  Copyright © 2026 kTeam. All rights reserved.
+//
+
+#ifndef MM_SEARCHMODE_H
+#define MM_SEARCHMODE_H
+
+#include <cstdint>
+
+/**
+ * How the tile placements are backed up. MINIMAX assumes the worst placement, EXPECTIMAX
+ * averages over placements with the game's odds of a 2 or a 4 in each hole.
+ */
+enum class SearchMode: uint_fast8_t {
+	MINIMAX, EXPECTIMAX
+};
+
+#endif /* MM_SEARCHMODE_H */
@@ -8,55 +8,221 @@
 
 #include "ShiftNode.h"
 #include "PlaceNode.h"
+#include "BasicBoard.h"
+#include "ScoreCache.h"
 #include <climits>
 #include <cstring>
+#include <vector>
 
 
-const PlaceNode* ShiftNode::kEmptyChildren[4] = {};
+template<class BoardType>
+const typename BasicShiftNode<BoardType>::PlaceNodeType* BasicShiftNode<BoardType>::kEmptyChildren[4] = {};
 
-std::queue<ShiftNode*> ShiftNode::sPool;
+// Each thread keeps its own table so searches on different threads never share live nodes.
+// Only freed nodes move between threads, through NodePool.
+template<class BoardType>
+thread_local NodeTable<typename BoardType::Grid, BasicShiftNode<BoardType>> BasicShiftNode<BoardType>::sTable;
 
+template<class BoardType>
+thread_local std::vector<BasicShiftNode<BoardType>*> BasicShiftNode<BoardType>::sDead;
 
-ShiftNode* ShiftNode::allocate(Board initBoard) {
-	if(!sPool.empty()) {
-		ShiftNode* ret = sPool.front();
-		sPool.pop();
-		ret->init(initBoard);
+template<class BoardType>
+thread_local uint32_t BasicShiftNode<BoardType>::sSearchStamp = 0;
+
+template<class BoardType>
+ScoreCache* BasicShiftNode<BoardType>::sScoreCache = nullptr;
+
+
+template<class BoardType>
+BasicShiftNode<BoardType>* BasicShiftNode<BoardType>::acquire(BoardType board) {
+	return acquire(board, board.lineScore());
+}
+
+
+template<class BoardType>
+BasicShiftNode<BoardType>* BasicShiftNode<BoardType>::acquire(BoardType board, int lineScore) {
+	BasicShiftNode* ret = sTable.find(board.getCompressedGrid());
+	if(ret) {
+		ret->retain();
 		return ret;
 	}
 	
-	return new ShiftNode(initBoard);
+	ret = NodePool<BasicShiftNode>::allocate(board, lineScore);
+	sTable.insert(board.getCompressedGrid(), ret);
+	return ret;
+}
+
+
+template<class BoardType>
+void BasicShiftNode<BoardType>::prefetchAcquire(BoardType board) {
+	sTable.prefetch(board.getCompressedGrid());
+}
+
+
+template<class BoardType>
+void BasicShiftNode<BoardType>::prefetchProbe(BoardType board) {
+	prefetchingCache(sScoreCache, board);
+}
+
+
+template<class BoardType>
+size_t BasicShiftNode<BoardType>::getLiveCount() {
+	return sTable.size();
+}
+
+
+template<class BoardType>
+size_t BasicShiftNode<BoardType>::getAllocatedCount() {
+	return NodePool<BasicShiftNode>::getHeldCount();
+}
+
+
+template<class BoardType>
+size_t BasicShiftNode<BoardType>::getHighWaterCount() {
+	return NodePool<BasicShiftNode>::getHighWaterCount();
+}
+
+
+template<class BoardType>
+size_t BasicShiftNode<BoardType>::getTableBytes() {
+	return sTable.getSlotBytes();
+}
+
+
+template<class BoardType>
+size_t BasicShiftNode<BoardType>::getHighWaterTableBytes() {
+	return sTable.getHighWaterSlotBytes();
+}
+
+
+template<class BoardType>
+void BasicShiftNode<BoardType>::shrinkTable() {
+	sTable.shrink();
+}
+
+
+template<class BoardType>
+void BasicShiftNode<BoardType>::trimPool(size_t keep) {
+	NodePool<BasicShiftNode>::trim(keep);
+}
+
+
+template<class BoardType>
+size_t BasicShiftNode<BoardType>::reclaim(size_t nodes) {
+	size_t freed = 0;
+	while(freed < nodes && !sDead.empty()) {
+		BasicShiftNode* node = sDead.back();
+		sDead.pop_back();
+		node->releaseChildren();
+		NodePool<BasicShiftNode>::deallocate(node);
+		++freed;
+	}
+	return freed;
+}
+
+
+template<class BoardType>
+size_t BasicShiftNode<BoardType>::getDeadCount() {
+	return sDead.size();
+}
+
+
+template<class BoardType>
+void BasicShiftNode<BoardType>::beginSearch() {
+	++sSearchStamp;
+}
+
+
+template<class BoardType>
+uint32_t BasicShiftNode<BoardType>::getSearchStamp() {
+	return sSearchStamp;
+}
+
+
+template<class BoardType>
+void BasicShiftNode<BoardType>::collapseBefore(uint32_t stamp) {
+	// Walking the table rather than the DAG sees each node once however many paths reach it.
+	// Collapsing frees nodes, so hold on to the cold ones until they've all been collapsed.
+	std::vector<BasicShiftNode*> cold;
+	sTable.forEach([&](BasicShiftNode* node) {
+		if(node->mLastSearched < stamp && memcmp(node->mChildren, kEmptyChildren, sizeof(node->mChildren)) != 0) {
+			node->retain();
+			cold.push_back(node);
+		}
+	});
+	
+	for(BasicShiftNode* node : cold) {
+		node->releaseChildren();
+	}
+	for(BasicShiftNode* node : cold) {
+		node->release();
+	}
 }
 
-ShiftNode::ShiftNode(Board initBoard)
+
+template<class BoardType>
+void BasicShiftNode<BoardType>::setScoreCache(ScoreCache* cache) {
+	sScoreCache = cache;
+}
+
+template<class BoardType>
+ScoreCache* BasicShiftNode<BoardType>::getScoreCache() {
+	return sScoreCache;
+}
+
+template<class BoardType>
+BasicShiftNode<BoardType>::BasicShiftNode(BoardType initBoard, int lineScore)
 : mBoard(initBoard) {
-	init(initBoard);
+	init(initBoard, lineScore);
 }
 
 
-void ShiftNode::init(Board initBoard) {
+template<class BoardType>
+void BasicShiftNode<BoardType>::init(BoardType initBoard, int lineScore) {
 	mBoard = initBoard;
+	mLineScore = lineScore;
+	mReferences = 1;
+	mLastSearched = sSearchStamp;
+	mBounds.reset();
 	memset(mChildren, 0, sizeof(mChildren));
 }
 
 
-void ShiftNode::deallocate() {
-	sPool.push(this);
+template<class BoardType>
+void BasicShiftNode<BoardType>::retain() {
+	++mReferences;
 }
 
 
-Board ShiftNode::getBoard() const {
-	return mBoard;
+template<class BoardType>
+void BasicShiftNode<BoardType>::release() {
+	if(--mReferences != 0) {
+		return;
+	}
+	
+	// Releasing the children here would tear down a whole subtree at once, in the middle of a
+	// move, so that's left for reclaim()
+	sTable.erase(mBoard.getCompressedGrid());
+	sDead.push_back(this);
+}
+
+
+template<class BoardType>
+void BasicShiftNode<BoardType>::prefetch() const {
+	// Pooled nodes are only as aligned as the allocator makes them, so one may span two lines
+	__builtin_prefetch(this);
+	__builtin_prefetch(&mBounds);
 }
 
 
-void ShiftNode::setBoard(Board newBoard) {
-	prune(nullptr);
-	mBoard = newBoard;
+template<class BoardType>
+BoardType BasicShiftNode<BoardType>::getBoard() const {
+	return mBoard;
 }
 
 
-PlaceNode* ShiftNode::getChild(Direction dir) {
+template<class BoardType>
+typename BasicShiftNode<BoardType>::PlaceNodeType* BasicShiftNode<BoardType>::getChild(Direction dir) {
 	if(memcmp(mChildren, kEmptyChildren, sizeof(mChildren)) == 0) {
 		populateChildren();
 	}
@@ -65,50 +231,74 @@ PlaceNode* ShiftNode::getChild(Direction dir) {
 }
 
 
-void ShiftNode::prune(ShiftNode* newHead) {
-	if(this == newHead) {
-		return;
-	}
-	
+template<class BoardType>
+void BasicShiftNode<BoardType>::releaseChildren() {
 	for(int i = 0; i < 4; i++) {
 		if(mChildren[i]) {
-			mChildren[i]->prune(newHead);
-			mChildren[i]->deallocate();
+			mChildren[i]->release();
 			mChildren[i] = nullptr;
 		}
 	}
 }
 
 
-void ShiftNode::populateChildren() {
-	Board shifts[4];
+template<class BoardType>
+void BasicShiftNode<BoardType>::populateChildren() {
+	BoardType shifts[4];
 	mBoard.allShifts(shifts);
 	
+	// Start every lookup before waiting on the first, rather than missing once per child in turn
 	for(int i = 0; i < 4; i++) {
 		if(!shifts[i].isEmpty()) {
-			mChildren[i] = PlaceNode::allocate(shifts[i]);
+			PlaceNodeType::prefetchAcquire(shifts[i]);
+		}
+	}
+	
+	for(int i = 0; i < 4; i++) {
+		if(!shifts[i].isEmpty()) {
+			mChildren[i] = PlaceNodeType::acquire(shifts[i], mBoard.updatedLineScore(mLineScore, shifts[i]));
 		}
 	}
 }
 
 
 // Smaller stack frame
-int ShiftNode::getMaxScore(unsigned depth, int alpha, int beta) {
+template<class BoardType>
+int BasicShiftNode<BoardType>::getMaxScore(unsigned depth, int alpha, int beta, SearchBudget& budget, bool nullWindows) {
+	if(!budget.spending()) {
+		return 0;
+	}
+	mLastSearched = sSearchStamp;
+	
 	if(depth == 0) {
-		return mBoard.estimateScore();
+		return mBoard.estimateScore(mLineScore);
+	}
+	
+	int score, maxScore = INT_MIN;
+	
+	// Earlier searches of this node may answer this one, or at least narrow its window
+	if(mBounds.probing(depth, alpha, beta, &score)) {
+		return score;
+	}
+	int origAlpha = alpha, origBeta = beta;
+	
+	// Reuse the result of an earlier search of this grid, possibly from another process
+	if(probingCache(sScoreCache, mBoard, depth, alpha, beta, &score)) {
+		return score;
 	}
 	
 	// Populate children if they haven't been yet
 	if(memcmp(mChildren, kEmptyChildren, sizeof(mChildren)) == 0) {
 		populateChildren();
 	}
-	
-	int score, maxScore = INT_MIN;
+	prefetchChildren();
 	
 	// Score children
+	bool first = true;
 	for(int i = 0; i < 4; i++) {
 		if(mChildren[i]) {
-			score = mChildren[i]->getMinScore(depth - 1, alpha, beta);
+			score = scoreChild(mChildren[i], depth - 1, alpha, beta, budget, nullWindows && !first);
+			first = false;
 			if(score > maxScore) {
 				maxScore = score;
 			}
@@ -116,32 +306,46 @@ int ShiftNode::getMaxScore(unsigned depth, int alpha, int beta) {
 				alpha = maxScore;
 			}
 			if(alpha >= beta) {
-				return maxScore;
+				break;
 			}
 		}
 	}
 	
+	// A search cut short by the budget returns garbage, which mustn't outlive it
+	if(!budget.isExhausted()) {
+		mBounds.store(depth, origAlpha, origBeta, maxScore);
+		storingCache(sScoreCache, mBoard, depth, origAlpha, origBeta, maxScore);
+	}
 	return maxScore;
 }
 
 
-int ShiftNode::getMaxScore(unsigned depth, int alpha, int beta, Direction* dir) {
+template<class BoardType>
+int BasicShiftNode<BoardType>::getMaxScore(unsigned depth, int alpha, int beta, SearchBudget& budget, bool nullWindows, Direction* dir) {
+	if(!budget.spending()) {
+		return 0;
+	}
+	mLastSearched = sSearchStamp;
+	
 	if(depth == 0) {
-		return mBoard.estimateScore();
+		return mBoard.estimateScore(mLineScore);
 	}
 	
 	// Populate children if they haven't been yet
 	if(memcmp(mChildren, kEmptyChildren, sizeof(mChildren)) == 0) {
 		populateChildren();
 	}
+	prefetchChildren();
 	
 	int score, maxScore = INT_MIN;
 	Direction maxDir;
 	
-	// Score children
+	// Score children. Zero-window searches cut off here too, and still need the move that did it.
+	bool first = true;
 	for(int i = 0; i < 4; i++) {
 		if(mChildren[i]) {
-			score = mChildren[i]->getMinScore(depth - 1, alpha, beta);
+			score = scoreChild(mChildren[i], depth - 1, alpha, beta, budget, nullWindows && !first);
+			first = false;
 			if(score > maxScore) {
 				maxScore = score;
 				maxDir = (Direction)i;
@@ -150,7 +354,7 @@ int ShiftNode::getMaxScore(unsigned depth, int alpha, int beta, Direction* dir)
 				alpha = maxScore;
 			}
 			if(alpha >= beta) {
-				return maxScore;
+				break;
 			}
 		}
 	}
@@ -170,3 +374,34 @@ int ShiftNode::getMaxScore(unsigned depth, int alpha, int beta, Direction* dir)
 	}
 	return maxScore;
 }
+
+
+template<class BoardType>
+void BasicShiftNode<BoardType>::prefetchChildren() const {
+	for(int i = 0; i < 4; i++) {
+		if(mChildren[i]) {
+			mChildren[i]->prefetch();
+		}
+	}
+}
+
+
+template<class BoardType>
+int BasicShiftNode<BoardType>::scoreChild(PlaceNodeType* child, unsigned depth, int alpha, int beta, SearchBudget& budget, bool nullWindow) {
+	if(!nullWindow) {
+		return child->getMinScore(depth, alpha, beta, budget, false);
+	}
+	
+	// Principal variation search: first try to show this move is no better than alpha, and only
+	// pay for a full window when it is
+	int score = child->getMinScore(depth, alpha, alpha + 1, budget, true);
+	if(score > alpha && score < beta) {
+		score = child->getMinScore(depth, alpha, beta, budget, true);
+	}
+	return score;
+}
+
+
+template class BasicShiftNode<Board>;
+template class BasicShiftNode<BasicBoard<4, 5>>;
+template class BasicShiftNode<BasicBoard<5, 4>>;
@@ -9,36 +9,146 @@
 #ifndef MM_SHIFTNODE_H
 #define MM_SHIFTNODE_H
 
-#include <queue>
+#include <vector>
 #include "Board.h"
+#include "NodeBounds.h"
+#include "NodePool.h"
+#include "NodeTable.h"
+#include "SearchBudget.h"
 
-class PlaceNode;
+template<class BoardType>
+class BasicPlaceNode;
+class ScoreCache;
 
-// This represents a maximizing node
-class ShiftNode {
+// This represents a maximizing node. Nodes are shared by every path to their board, so the tree
+// is really a DAG, and each node counts the parents (and BoardTree heads) referencing it.
+template<class BoardType>
+class BasicShiftNode {
 public:
-	static ShiftNode* allocate(Board initBoard);
+	typedef BasicPlaceNode<BoardType> PlaceNodeType;
 	
-	ShiftNode(Board initBoard);
-	void init(Board initBoard);
-	void deallocate();
+	/**
+	 * The node for @p board, shared with any other holder of it on this thread.
+	 * @return A node with a reference held for the caller
+	 */
+	static BasicShiftNode* acquire(BoardType board);
+	static BasicShiftNode* acquire(BoardType board, int lineScore);
 	
-	Board getBoard() const;
-	void setBoard(Board newBoard);
-	PlaceNode* getChild(Direction dir);
-	void prune(ShiftNode* newHead);
-	int getMaxScore(unsigned depth, int alpha, int beta);
-	int getMaxScore(unsigned depth, int alpha, int beta, Direction* dir);
+	/**
+	 * Start loading what acquire() of @p board and a search of it will look up first: its slot
+	 * in this thread's table and its score cache entry.
+	 */
+	static void prefetchAcquire(BoardType board);
+	static void prefetchProbe(BoardType board);
 	
+	/**
+	 * Number of shift nodes alive on this thread.
+	 */
+	static size_t getLiveCount();
+	
+	/**
+	 * Shift nodes this thread holds, alive or pooled, now and at most.
+	 */
+	static size_t getAllocatedCount();
+	static size_t getHighWaterCount();
+	
+	/**
+	 * Bytes of this thread's table of live shift nodes, now and at most.
+	 */
+	static size_t getTableBytes();
+	static size_t getHighWaterTableBytes();
+	
+	/**
+	 * Give back table slots left empty by freed nodes. See NodeTable::shrink().
+	 */
+	static void shrinkTable();
+	
+	/**
+	 * Free this thread's pooled nodes until at most @p keep are left, and the ones other
+	 * threads gave up.
+	 */
+	static void trimPool(size_t keep);
+	
+	/**
+	 * Finish freeing up to @p nodes nodes whose last reference is gone, releasing their children.
+	 * Children that lose their last reference are queued in turn rather than freed at once.
+	 * @return Number of nodes freed
+	 */
+	static size_t reclaim(size_t nodes);
+	static size_t getDeadCount();
+	
+	/**
+	 * Start a new search on this thread. Nodes remember the last search that visited them, so
+	 * the coldest subtrees can be collapsed first.
+	 */
+	static void beginSearch();
+	static uint32_t getSearchStamp();
+	
+	/**
+	 * Turn every node on this thread that no search has visited since @p stamp back into an
+	 * unexpanded leaf, releasing its subtree.
+	 */
+	static void collapseBefore(uint32_t stamp);
+	
+	/**
+	 * Share search results through a persistent cache. Only searches over the 64-bit Board
+	 * use it; other board types ignore the cache.
+	 */
+	static void setScoreCache(ScoreCache* cache);
+	static ScoreCache* getScoreCache();
+	
+	BasicShiftNode(BoardType initBoard, int lineScore);
+	void init(BoardType initBoard, int lineScore);
+	void retain();
+	
+	/**
+	 * Drop a reference. The last one unshares the node and queues it for reclaim().
+	 */
+	void release();
+	
+	/**
+	 * Start loading the node, so the parent can overlap the misses of all its children.
+	 */
+	void prefetch() const;
+	
+	BoardType getBoard() const;
+	PlaceNodeType* getChild(Direction dir);
+	void releaseChildren();
+	/**
+	 * Alpha-beta search to @p depth shifts.
+	 * @param nullWindows Search every move after the first with a null window (PVS)
+	 */
+	int getMaxScore(unsigned depth, int alpha, int beta, SearchBudget& budget, bool nullWindows);
+	int getMaxScore(unsigned depth, int alpha, int beta, SearchBudget& budget, bool nullWindows, Direction* dir);
+
 private:
 	void populateChildren();
 	
-	static const PlaceNode* kEmptyChildren[4];
+	/**
+	 * Start loading every child before the first is scored, since the siblings' misses would
+	 * otherwise come one at a time as the loop reaches them.
+	 */
+	void prefetchChildren() const;
 	
-	static std::queue<ShiftNode*> sPool;
+	int scoreChild(PlaceNodeType* child, unsigned depth, int alpha, int beta, SearchBudget& budget, bool nullWindow);
 	
-	PlaceNode* mChildren[4];
-	Board mBoard;
+	static const PlaceNodeType* kEmptyChildren[4];
+	
+	static thread_local NodeTable<typename BoardType::Grid, BasicShiftNode> sTable;
+	static thread_local std::vector<BasicShiftNode*> sDead;
+	static thread_local uint32_t sSearchStamp;
+	static ScoreCache* sScoreCache;
+	
+	PlaceNodeType* mChildren[4];
+	BoardType mBoard;
+	uint32_t mReferences;
+	uint32_t mLastSearched;
+	
+	// Cached BoardType::lineScore(), kept up to date incrementally from the parent
+	int mLineScore;
+	NodeBounds mBounds;
 };
 
+typedef BasicShiftNode<Board> ShiftNode;
+
 #endif /* MM_SHIFTNODE_H */
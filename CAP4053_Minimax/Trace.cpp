@@ -0,0 +1,130 @@
+//
+//  Trace.cpp
+//  CAP4053_Minimax
+//
+//  Created by kTeam on 10/19/26.
+//  Copyright © 2026 kTeam. All rights reserved.
+//
+
+#include "Trace.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+
+// Spans a thread buffers before writing them out
+static const size_t kFlushSpans = 4096;
+
+struct TraceSpan {
+	const char* name;
+	uint64_t start;
+	uint64_t end;
+};
+
+std::atomic<bool> Trace::sOpen(false);
+
+static std::mutex sMutex;
+static FILE* sFile = nullptr;
+static bool sFirstSpan = true;
+static uint64_t sEpoch = 0;
+static std::atomic<uint32_t> sNextThread(1);
+
+struct ThreadSpans;
+static void flushing(std::vector<TraceSpan>& spans, uint32_t thread);
+
+// This thread's buffer while it exists. Exit destroys it before close() runs from atexit(), and
+// unlike the buffer, this can still be read then.
+static thread_local ThreadSpans* sLiveSpans = nullptr;
+
+// The trace event format wants small thread ids, so threads are numbered as they first record
+struct ThreadSpans {
+	ThreadSpans()
+	: thread(sNextThread++) {
+		sLiveSpans = this;
+	}
+	
+	~ThreadSpans() {
+		flushing(spans, thread);
+		sLiveSpans = nullptr;
+	}
+	
+	std::vector<TraceSpan> spans;
+	uint32_t thread;
+};
+
+static thread_local ThreadSpans sSpans;
+
+
+static void flushing(std::vector<TraceSpan>& spans, uint32_t thread) {
+	std::lock_guard<std::mutex> lock(sMutex);
+	if(sFile) {
+		// Complete events, with times in microseconds since the trace was opened
+		for(const TraceSpan& span : spans) {
+			// A span that began before the trace was last opened belongs to an earlier trace,
+			// and would land far off the end of this one's timeline
+			if(span.start < sEpoch) {
+				continue;
+			}
+			fprintf(sFile, "%s{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+				sFirstSpan ? "" : ",\n", span.name, (span.start - sEpoch) / 1e3, (span.end - span.start) / 1e3, thread);
+			sFirstSpan = false;
+		}
+	}
+	spans.clear();
+}
+
+
+bool Trace::open(const char* path) {
+#ifndef MM_TRACING
+	std::cerr << "This build has no trace spans; define MM_TRACING to record them" << std::endl;
+#endif
+	close();
+	
+	std::lock_guard<std::mutex> lock(sMutex);
+	sFile = fopen(path, "w");
+	if(!sFile) {
+		std::cerr << "Failed to create trace file " << path << ": " << strerror(errno) << std::endl;
+		return false;
+	}
+	
+	static std::once_flag sAtExit;
+	std::call_once(sAtExit, [] {
+		atexit(close);
+	});
+	
+	fprintf(sFile, "[\n");
+	sFirstSpan = true;
+	sEpoch = now();
+	sOpen = true;
+	return true;
+}
+
+
+void Trace::close() {
+	if(!isOpen()) {
+		return;
+	}
+	sOpen = false;
+	if(ThreadSpans* spans = sLiveSpans) {
+		flushing(spans->spans, spans->thread);
+	}
+	
+	// Viewers also accept a trace whose closing bracket is missing, as after a crash
+	std::lock_guard<std::mutex> lock(sMutex);
+	fprintf(sFile, "\n]\n");
+	fclose(sFile);
+	sFile = nullptr;
+}
+
+
+void Trace::record(const char* name, uint64_t start, uint64_t end) {
+	ThreadSpans& spans = sSpans;
+	spans.spans.push_back({name, start, end});
+	if(spans.spans.size() >= kFlushSpans) {
+		flushing(spans.spans, spans.thread);
+	}
+}
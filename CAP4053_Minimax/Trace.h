@@ -0,0 +1,89 @@
+//
+//  Trace.h
+//  CAP4053_Minimax
+//
+//  Created by kTeam on 10/19/26.
+//  Copyright © 2026 kTeam. All rights reserved.
+//
+
+#ifndef MM_TRACE_H
+#define MM_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+
+/**
+ * Timeline of what the game spent its time on, written in Chrome's trace event format so a
+ * whole session opens in chrome://tracing or Perfetto. Code marks phases with MM_TRACE_SPAN(),
+ * which times the rest of the enclosing scope.
+ *
+ * Spans only exist in builds with MM_TRACING defined, and are compiled out otherwise. Even then
+ * they cost a relaxed load until a trace is opened. Each thread buffers its spans and writes
+ * them out in batches, so a span costs two clock reads and no locking.
+ */
+class Trace {
+public:
+	/**
+	 * Start writing spans to a new trace file at @p path. The file is finished when the trace is
+	 * closed, or at exit.
+	 * @return False if the file couldn't be created
+	 */
+	static bool open(const char* path);
+	
+	/**
+	 * Write out this thread's spans and finish the file. Spans other threads still hold are
+	 * dropped, so close the trace from the last thread to record any.
+	 */
+	static void close();
+	
+	static bool isOpen() {
+		return sOpen.load(std::memory_order_relaxed);
+	}
+	
+	/**
+	 * Nanoseconds on a monotonic clock, for span timestamps.
+	 */
+	static uint64_t now() {
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+	
+	/**
+	 * Record that @p name, which must be a string literal, ran from @p start to @p end.
+	 */
+	static void record(const char* name, uint64_t start, uint64_t end);
+	
+	class Span {
+	public:
+		explicit Span(const char* name)
+		: mName(name), mStart(isOpen() ? now() : 0) { }
+		
+		~Span() {
+			if(mStart) {
+				record(mName, mStart, now());
+			}
+		}
+	
+	private:
+		Span(const Span&);
+		Span& operator=(const Span&);
+		
+		const char* mName;
+		uint64_t mStart;
+	};
+
+private:
+	static std::atomic<bool> sOpen;
+};
+
+
+#ifdef MM_TRACING
+#define MM_TRACE_JOIN(a, b) a##b
+#define MM_TRACE_NAME(line) MM_TRACE_JOIN(traceSpan, line)
+#define MM_TRACE_SPAN(name) Trace::Span MM_TRACE_NAME(__LINE__)(name)
+#else
+#define MM_TRACE_SPAN(name) do { } while(0)
+#endif
+
+#endif /* MM_TRACE_H */
@@ -13,15 +13,50 @@
 
 #include "Engine/GameEngine.h"
 #include "Board.h"
+#include "HugePages.h"
+#include "ShiftNode.h"
+#include "ScoreCache.h"
+#include "Trace.h"
+#include "NTupleEvaluator.h"
 
 
 int main() {
 	// Seed random number generator
 	srand((unsigned)time(nullptr));
 	
-	// Prepare the lookup tables
+	// Prepare the lookup tables, optionally with heuristic weights found by the tuner
+	HeuristicWeights weights;
+	if(const char* weightsText = getenv("MM_HEURISTIC_WEIGHTS")) {
+		if(!weights.parse(weightsText)) {
+			std::cerr << "Ignoring malformed MM_HEURISTIC_WEIGHTS: " << weightsText << std::endl;
+			weights = HeuristicWeights();
+		}
+	}
+	// Back the tables, tree nodes and score cache with huge pages if requested
+	if(getenv("MM_HUGE_PAGES")) {
+		HugePages::setEnabled(true);
+	}
 	Board::fillShiftTable();
-	Board::fillScoreTable();
+	Board::fillScoreTable(weights);
+	
+	// Score leaves with a learned n-tuple network instead of the handcrafted heuristic
+	std::unique_ptr<NTupleEvaluator> evaluator;
+	if(const char* weightsPath = getenv("MM_NTUPLE_WEIGHTS")) {
+		evaluator = NTupleEvaluator::load(weightsPath);
+		Board::setEvaluator(evaluator.get());
+	}
+	
+	// Warm-start searches from a persistent score cache if one was requested
+	std::unique_ptr<ScoreCache> cache;
+	if(const char* cachePath = getenv("MM_SCORE_CACHE")) {
+		cache = ScoreCache::open(cachePath, 1 << 22, Board::heuristicVersion());
+		ShiftNode::setScoreCache(cache.get());
+	}
+	
+	// Record a timeline of searches and frames if requested, in builds with trace spans
+	if(const char* tracePath = getenv("MM_TRACE_FILE")) {
+		Trace::open(tracePath);
+	}
 	
 	// Run the game in a 600x800 portrait window
 	GameEngine game{"2048 AI", 600, 800};
@@ -0,0 +1,264 @@
+//
+//  main.cpp
+//  Trainer
+//
+//  Created by kTeam on 10/19/26.
+//  Copyright © 2026 kTeam. All rights reserved.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include "Board.h"
+#include "NTupleEvaluator.h"
+
+
+/*
+ * Trains NTupleEvaluator weights with afterstate TD(0) self-play. Every thread plays its own
+ * games and updates the shared weight tables without locks (Hogwild style). Weights are
+ * checkpointed periodically and when training stops.
+ */
+
+struct TrainerStats {
+	// Games claimed against the -n limit, and games played to the end
+	std::atomic<uint64_t> started{0};
+	std::atomic<uint64_t> games{0};
+	std::atomic<uint64_t> moves{0};
+	std::atomic<uint64_t> totalScore{0};
+	std::atomic<unsigned> maxTile{0};
+};
+
+static std::atomic<bool> gStopping{false};
+
+
+static void stopTraining(int) {
+	gStopping = true;
+}
+
+
+/**
+ * Pick the move with the best immediate reward plus afterstate value.
+ * @return False if no move changes the board
+ */
+static bool chooseMove(const NTupleEvaluator& evaluator, Board board, Board* pAfter, unsigned* pReward) {
+	bool found = false;
+	float bestValue = 0.0f;
+	for(int i = 0; i < 4; i++) {
+		Direction dir = (Direction)i;
+		Board after = board;
+		if(!after.shiftTiles(dir)) {
+			continue;
+		}
+		
+		unsigned reward = board.shiftScore(dir);
+		float value = reward + evaluator.value(after.getCompressedGrid());
+		if(!found || value > bestValue) {
+			found = true;
+			bestValue = value;
+			*pAfter = after;
+			*pReward = reward;
+		}
+	}
+	return found;
+}
+
+
+static void playGames(NTupleEvaluator& evaluator, float alpha, uint64_t gameLimit, unsigned seed, TrainerStats& stats) {
+	std::mt19937 rng(seed);
+	
+	while(!gStopping && (gameLimit == 0 || stats.started.fetch_add(1) < gameLimit)) {
+		Board board;
+		board.placeRandom(rng);
+		board.placeRandom(rng);
+		
+		Board prevAfter, after;
+		bool hasPrev = false;
+		unsigned reward;
+		uint64_t score = 0, moves = 0;
+		
+		while(chooseMove(evaluator, board, &after, &reward)) {
+			// V(s'_prev) <- V(s'_prev) + alpha * (r + V(s') - V(s'_prev))
+			if(hasPrev) {
+				CompressedGrid prevGrid = prevAfter.getCompressedGrid();
+				float target = reward + evaluator.value(after.getCompressedGrid());
+				evaluator.update(prevGrid, alpha * (target - evaluator.value(prevGrid)));
+			}
+			
+			score += reward;
+			++moves;
+			prevAfter = after;
+			hasPrev = true;
+			
+			board = after;
+			board.placeRandom(rng);
+		}
+		
+		// The final afterstate leads nowhere, so its target value is zero
+		if(hasPrev) {
+			CompressedGrid prevGrid = prevAfter.getCompressedGrid();
+			evaluator.update(prevGrid, -alpha * evaluator.value(prevGrid));
+		}
+		
+		stats.moves.fetch_add(moves);
+		stats.totalScore.fetch_add(score);
+		
+		unsigned tile = board.maxTile();
+		unsigned prevMax = stats.maxTile.load();
+		while(tile > prevMax && !stats.maxTile.compare_exchange_weak(prevMax, tile)) { }
+		
+		// Only count the game once its moves and score are in, so the averages never include
+		// games still being played
+		stats.games.fetch_add(1);
+	}
+}
+
+
+static bool checkpoint(const NTupleEvaluator& evaluator, const std::string& path) {
+	// Write next to the real file and rename, so a crash never leaves a half-written checkpoint
+	std::string tmpPath = path + ".tmp";
+	if(!evaluator.save(tmpPath.c_str())) {
+		return false;
+	}
+	if(rename(tmpPath.c_str(), path.c_str()) != 0) {
+		perror("rename");
+		return false;
+	}
+	return true;
+}
+
+
+static void usage(const char* argv0) {
+	fprintf(stderr,
+		"Usage: %s [-j threads] [-n games] [-a alpha] [-i weights] [-c seconds] output\n"
+		"  -j threads  Number of self-play threads (default: one per core)\n"
+		"  -n games    Stop after this many games (default: run until interrupted)\n"
+		"  -a alpha    Learning rate (default: 0.0025)\n"
+		"  -i weights  Continue training from an existing weights file\n"
+		"  -c seconds  Checkpoint interval (default: 60)\n",
+		argv0
+	);
+	exit(EXIT_FAILURE);
+}
+
+
+int main(int argc, char** argv) {
+	unsigned threadCount = std::thread::hardware_concurrency();
+	uint64_t gameLimit = 0;
+	float alpha = 0.0025f;
+	const char* inputPath = nullptr;
+	double checkpointSeconds = 60.0;
+	
+	int opt;
+	while((opt = getopt(argc, argv, "j:n:a:i:c:")) != -1) {
+		switch(opt) {
+			case 'j':
+				threadCount = (unsigned)atoi(optarg);
+				break;
+			
+			case 'n':
+				gameLimit = strtoull(optarg, nullptr, 10);
+				break;
+			
+			case 'a':
+				alpha = strtof(optarg, nullptr);
+				break;
+			
+			case 'i':
+				inputPath = optarg;
+				break;
+			
+			case 'c':
+				checkpointSeconds = strtod(optarg, nullptr);
+				break;
+			
+			default:
+				usage(argv[0]);
+		}
+	}
+	if(argc - optind != 1) {
+		usage(argv[0]);
+	}
+	if(threadCount == 0) {
+		threadCount = 1;
+	}
+	std::string outputPath = argv[optind];
+	
+	// Prepare the lookup tables
+	Board::fillShiftTable();
+	Board::fillScoreTable();
+	
+	std::unique_ptr<NTupleEvaluator> evaluator;
+	if(inputPath) {
+		evaluator = NTupleEvaluator::load(inputPath);
+		if(!evaluator) {
+			return EXIT_FAILURE;
+		}
+	}
+	else {
+		evaluator = std::make_unique<NTupleEvaluator>(NTupleEvaluator::defaultPatterns());
+	}
+	
+	signal(SIGINT, stopTraining);
+	signal(SIGTERM, stopTraining);
+	
+	TrainerStats stats;
+	std::atomic<unsigned> running{threadCount};
+	std::random_device seeder;
+	std::vector<std::thread> threads;
+	for(unsigned i = 0; i < threadCount; i++) {
+		unsigned seed = seeder();
+		threads.emplace_back([&, seed] {
+			playGames(*evaluator, alpha, gameLimit, seed, stats);
+			running.fetch_sub(1);
+		});
+	}
+	
+	// Report progress and checkpoint until every thread has finished
+	typedef std::chrono::steady_clock Clock;
+	Clock::time_point startTime = Clock::now(), lastReport = startTime, lastCheckpoint = startTime;
+	uint64_t lastGames = 0, lastMoves = 0, lastScore = 0;
+	while(running) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(200));
+		Clock::time_point now = Clock::now();
+		
+		double sinceReport = std::chrono::duration<double>(now - lastReport).count();
+		if(sinceReport >= 5.0 || !running) {
+			uint64_t games = stats.games;
+			uint64_t moves = stats.moves, score = stats.totalScore;
+			uint64_t newGames = games - lastGames;
+			fprintf(stderr, "%llu games, %.1f games/sec, %.0f moves/sec, avg score %.0f, max tile %u\n",
+				(unsigned long long)games, newGames / sinceReport, (moves - lastMoves) / sinceReport,
+				newGames ? (double)(score - lastScore) / newGames : 0.0, 1u << stats.maxTile.load()
+			);
+			lastReport = now;
+			lastGames = games;
+			lastMoves = moves;
+			lastScore = score;
+		}
+		
+		if(std::chrono::duration<double>(now - lastCheckpoint).count() >= checkpointSeconds) {
+			checkpoint(*evaluator, outputPath);
+			lastCheckpoint = now;
+		}
+	}
+	for(std::thread& thread : threads) {
+		thread.join();
+	}
+	
+	double seconds = std::chrono::duration<double>(Clock::now() - startTime).count();
+	uint64_t games = stats.games;
+	fprintf(stderr, "Trained on %llu games in %.1fs (%.1f games/sec) on %u threads\n",
+		(unsigned long long)games, seconds, games / seconds, threadCount
+	);
+	return checkpoint(*evaluator, outputPath) ? 0 : EXIT_FAILURE;
+}
@@ -0,0 +1,446 @@
+//
+//  main.cpp
+//  Tuner
+//
+//  Created by kTeam on 10/19/26.
+//  Copyright © 2026 kTeam. All rights reserved.
+//
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include "Board.h"
+#include "BoardTree.h"
+
+
+/*
+ * Tunes the weights of the handcrafted scoreLine heuristic with CMA-ES. Every candidate weight
+ * vector rebuilds the Board::lineTable scores and is scored by the average result of a batch
+ * of headless games, played in parallel by a pool of worker threads. Candidates of one
+ * generation all play the same game seeds so they are compared on equal footing.
+ */
+
+static const unsigned kDimensions = 4;
+
+typedef std::array<double, kDimensions> Vector;
+typedef std::array<Vector, kDimensions> Matrix;
+
+
+static HeuristicWeights weightsFromVector(const Vector& x) {
+	HeuristicWeights weights;
+	weights.emptyTile = (int)lround(x[0]);
+	weights.bigTileOnEdge = (int)lround(x[1]);
+	weights.nearMerge = (int)lround(x[2]);
+	weights.monotonic = (int)lround(x[3]);
+	return weights;
+}
+
+
+static Vector vectorFromWeights(const HeuristicWeights& weights) {
+	return {(double)weights.emptyTile, (double)weights.bigTileOnEdge, (double)weights.nearMerge, (double)weights.monotonic};
+}
+
+
+/**
+ * Pool of threads that play batches of games with whatever scores are in Board::lineTable. The
+ * table is only rebuilt between batches, while every worker is idle.
+ */
+class GameRunner {
+public:
+	GameRunner(unsigned threadCount, unsigned depth)
+	: mDepth(depth), mRound(0), mStopping(false), mGameCount(0), mSeed(0), mFinished(0), mTotalScore(0) {
+		for(unsigned i = 0; i < threadCount; i++) {
+			mThreads.emplace_back(&GameRunner::work, this);
+		}
+	}
+	
+	~GameRunner() {
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mStopping = true;
+		}
+		mStart.notify_all();
+		for(std::thread& thread : mThreads) {
+			thread.join();
+		}
+	}
+	
+	/**
+	 * Play @p gameCount games with the given weights.
+	 * @return Average final score
+	 */
+	double play(const HeuristicWeights& weights, unsigned gameCount, uint32_t seed) {
+		Board::fillScoreTable(weights);
+		
+		std::unique_lock<std::mutex> lock(mMutex);
+		mGameCount = gameCount;
+		mSeed = seed;
+		mNextGame = 0;
+		mFinished = 0;
+		mTotalScore = 0;
+		++mRound;
+		mStart.notify_all();
+		
+		mDone.wait(lock, [&] { return mFinished == mThreads.size(); });
+		return (double)mTotalScore / gameCount;
+	}
+
+private:
+	void work() {
+		BoardTree tree{Board()};
+		tree.setLogging(false);
+		tree.setMaximumDepth(mDepth);
+		
+		uint64_t seenRound = 0;
+		while(true) {
+			{
+				std::unique_lock<std::mutex> lock(mMutex);
+				mStart.wait(lock, [&] { return mStopping || mRound != seenRound; });
+				if(mStopping) {
+					return;
+				}
+				seenRound = mRound;
+			}
+			
+			uint64_t score = 0;
+			unsigned game;
+			while((game = mNextGame.fetch_add(1)) < mGameCount) {
+				score += playGame(tree, mSeed + game);
+			}
+			
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				mTotalScore += score;
+				++mFinished;
+			}
+			mDone.notify_one();
+		}
+	}
+	
+	static unsigned playGame(BoardTree& tree, uint32_t seed) {
+		std::mt19937 rng(seed);
+		Board board;
+		board.placeRandom(rng);
+		board.placeRandom(rng);
+		
+		unsigned score = 0;
+		while(!board.isGameOver()) {
+			tree.setBoard(board);
+			Direction dir = tree.getBestMove();
+			score += board.shiftScore(dir);
+			board.shiftTiles(dir);
+			board.placeRandom(rng);
+		}
+		return score;
+	}
+	
+	std::vector<std::thread> mThreads;
+	std::mutex mMutex;
+	std::condition_variable mStart, mDone;
+	unsigned mDepth;
+	uint64_t mRound;
+	bool mStopping;
+	unsigned mGameCount;
+	uint32_t mSeed;
+	std::atomic<unsigned> mNextGame;
+	unsigned mFinished;
+	uint64_t mTotalScore;
+};
+
+
+/**
+ * Eigendecomposition of a symmetric matrix by cyclic Jacobi rotations. On return the columns
+ * of @p vectors are the eigenvectors of @p m and @p values their eigenvalues.
+ */
+static void eigenSymmetric(Matrix m, Matrix& vectors, Vector& values) {
+	for(unsigned i = 0; i < kDimensions; i++) {
+		for(unsigned j = 0; j < kDimensions; j++) {
+			vectors[i][j] = (i == j) ? 1.0 : 0.0;
+		}
+	}
+	
+	for(int sweep = 0; sweep < 50; sweep++) {
+		double offDiagonal = 0.0;
+		for(unsigned p = 0; p < kDimensions; p++) {
+			for(unsigned q = p + 1; q < kDimensions; q++) {
+				offDiagonal += m[p][q] * m[p][q];
+			}
+		}
+		if(offDiagonal < 1e-22) {
+			break;
+		}
+		
+		for(unsigned p = 0; p < kDimensions; p++) {
+			for(unsigned q = p + 1; q < kDimensions; q++) {
+				if(m[p][q] == 0.0) {
+					continue;
+				}
+				
+				double theta = (m[q][q] - m[p][p]) / (2.0 * m[p][q]);
+				double t = (theta >= 0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+				double c = 1.0 / sqrt(t * t + 1.0), s = t * c;
+				
+				for(unsigned k = 0; k < kDimensions; k++) {
+					double mkp = m[k][p], mkq = m[k][q];
+					m[k][p] = c * mkp - s * mkq;
+					m[k][q] = s * mkp + c * mkq;
+				}
+				for(unsigned k = 0; k < kDimensions; k++) {
+					double mpk = m[p][k], mqk = m[q][k];
+					m[p][k] = c * mpk - s * mqk;
+					m[q][k] = s * mpk + c * mqk;
+				}
+				for(unsigned k = 0; k < kDimensions; k++) {
+					double vkp = vectors[k][p], vkq = vectors[k][q];
+					vectors[k][p] = c * vkp - s * vkq;
+					vectors[k][q] = s * vkp + c * vkq;
+				}
+			}
+		}
+	}
+	
+	for(unsigned i = 0; i < kDimensions; i++) {
+		values[i] = m[i][i];
+	}
+}
+
+
+static void usage(const char* argv0) {
+	fprintf(stderr,
+		"Usage: %s [-j threads] [-n games] [-g generations] [-d depth] [-s sigma] [-w weights] [-r seed]\n"
+		"  -j threads      Number of game threads (default: one per core)\n"
+		"  -n games        Games played per candidate (default: 32)\n"
+		"  -g generations  Number of CMA-ES generations (default: 30)\n"
+		"  -d depth        Maximum search depth of the games (default: 2)\n"
+		"  -s sigma        Initial step size relative to each weight (default: 0.3)\n"
+		"  -w weights      Starting weights as a,b,c,d (default: the built-in weights)\n"
+		"  -r seed         Seed for sampling and games (default: random)\n",
+		argv0
+	);
+	exit(EXIT_FAILURE);
+}
+
+
+int main(int argc, char** argv) {
+	unsigned threadCount = std::thread::hardware_concurrency();
+	unsigned gameCount = 32;
+	unsigned generations = 30;
+	unsigned depth = 2;
+	double relativeSigma = 0.3;
+	HeuristicWeights startWeights;
+	uint32_t seed = std::random_device()();
+	
+	int opt;
+	while((opt = getopt(argc, argv, "j:n:g:d:s:w:r:")) != -1) {
+		switch(opt) {
+			case 'j':
+				threadCount = (unsigned)atoi(optarg);
+				break;
+			
+			case 'n':
+				gameCount = (unsigned)atoi(optarg);
+				break;
+			
+			case 'g':
+				generations = (unsigned)atoi(optarg);
+				break;
+			
+			case 'd':
+				depth = (unsigned)atoi(optarg);
+				break;
+			
+			case 's':
+				relativeSigma = strtod(optarg, nullptr);
+				break;
+			
+			case 'w':
+				if(!startWeights.parse(optarg)) {
+					fprintf(stderr, "Malformed weights: %s\n", optarg);
+					usage(argv[0]);
+				}
+				break;
+			
+			case 'r':
+				seed = (uint32_t)strtoul(optarg, nullptr, 10);
+				break;
+			
+			default:
+				usage(argv[0]);
+		}
+	}
+	if(optind != argc || gameCount == 0 || relativeSigma <= 0.0) {
+		usage(argv[0]);
+	}
+	if(threadCount == 0) {
+		threadCount = 1;
+	}
+	
+	Board::fillShiftTable();
+	GameRunner runner(threadCount, depth);
+	std::mt19937 rng(seed);
+	std::normal_distribution<double> gaussian;
+	
+	// Search in coordinates scaled by the starting weights so every dimension moves alike
+	Vector scale = vectorFromWeights(startWeights);
+	for(double& s : scale) {
+		s = std::max(fabs(s), 1.0);
+	}
+	
+	// Strategy parameters, as recommended by Hansen's CMA-ES tutorial
+	const unsigned n = kDimensions;
+	const unsigned lambda = 4 + (unsigned)(3 * log((double)n));
+	const unsigned mu = lambda / 2;
+	std::vector<double> recombination(mu);
+	for(unsigned i = 0; i < mu; i++) {
+		recombination[i] = log(mu + 0.5) - log(i + 1.0);
+	}
+	double weightSum = std::accumulate(recombination.begin(), recombination.end(), 0.0);
+	double squareSum = 0.0;
+	for(double& w : recombination) {
+		w /= weightSum;
+		squareSum += w * w;
+	}
+	const double mueff = 1.0 / squareSum;
+	const double cc = (4.0 + mueff / n) / (n + 4.0 + 2.0 * mueff / n);
+	const double cs = (mueff + 2.0) / (n + mueff + 5.0);
+	const double c1 = 2.0 / ((n + 1.3) * (n + 1.3) + mueff);
+	const double cmu = std::min(1.0 - c1, 2.0 * (mueff - 2.0 + 1.0 / mueff) / ((n + 2.0) * (n + 2.0) + mueff));
+	const double damps = 1.0 + 2.0 * std::max(0.0, sqrt((mueff - 1.0) / (n + 1.0)) - 1.0) + cs;
+	const double chiN = sqrt((double)n) * (1.0 - 1.0 / (4.0 * n) + 1.0 / (21.0 * n * n));
+	
+	// Distribution state
+	Vector mean, pc = {}, ps = {};
+	mean.fill(1.0);
+	double sigma = relativeSigma;
+	Matrix C = {}, B = {};
+	Vector D;
+	for(unsigned i = 0; i < n; i++) {
+		C[i][i] = 1.0;
+	}
+	
+	HeuristicWeights bestWeights = startWeights;
+	double bestFitness = runner.play(startWeights, gameCount, seed);
+	fprintf(stderr, "Starting weights %d,%d,%d,%d average %.0f\n",
+		startWeights.emptyTile, startWeights.bigTileOnEdge, startWeights.nearMerge, startWeights.monotonic, bestFitness
+	);
+	
+	auto startTime = std::chrono::steady_clock::now();
+	for(unsigned gen = 0; gen < generations; gen++) {
+		eigenSymmetric(C, B, D);
+		for(double& d : D) {
+			d = sqrt(std::max(d, 1e-20));
+		}
+		
+		// Sample and score this generation's candidates on a shared set of games
+		uint32_t genSeed = rng();
+		std::vector<Vector> samples(lambda), steps(lambda);
+		std::vector<double> fitness(lambda);
+		for(unsigned k = 0; k < lambda; k++) {
+			Vector z;
+			for(double& zi : z) {
+				zi = gaussian(rng);
+			}
+			for(unsigned i = 0; i < n; i++) {
+				double y = 0.0;
+				for(unsigned j = 0; j < n; j++) {
+					y += B[i][j] * D[j] * z[j];
+				}
+				steps[k][i] = y;
+				samples[k][i] = mean[i] + sigma * y;
+			}
+			
+			Vector x;
+			for(unsigned i = 0; i < n; i++) {
+				x[i] = samples[k][i] * scale[i];
+			}
+			HeuristicWeights weights = weightsFromVector(x);
+			fitness[k] = runner.play(weights, gameCount, genSeed);
+			if(fitness[k] > bestFitness) {
+				bestFitness = fitness[k];
+				bestWeights = weights;
+			}
+		}
+		
+		std::vector<unsigned> order(lambda);
+		std::iota(order.begin(), order.end(), 0);
+		std::sort(order.begin(), order.end(), [&](unsigned a, unsigned b) { return fitness[a] > fitness[b]; });
+		
+		// Move the mean towards the best candidates
+		Vector yw = {};
+		for(unsigned i = 0; i < mu; i++) {
+			for(unsigned j = 0; j < n; j++) {
+				yw[j] += recombination[i] * steps[order[i]][j];
+			}
+		}
+		for(unsigned j = 0; j < n; j++) {
+			mean[j] += sigma * yw[j];
+		}
+		
+		// Step size path uses C^-1/2 * yw = B * D^-1 * B^T * yw
+		Vector bty = {};
+		for(unsigned i = 0; i < n; i++) {
+			for(unsigned j = 0; j < n; j++) {
+				bty[i] += B[j][i] * yw[j];
+			}
+			bty[i] /= D[i];
+		}
+		double psNorm = 0.0;
+		for(unsigned i = 0; i < n; i++) {
+			double invSqrtY = 0.0;
+			for(unsigned j = 0; j < n; j++) {
+				invSqrtY += B[i][j] * bty[j];
+			}
+			ps[i] = (1.0 - cs) * ps[i] + sqrt(cs * (2.0 - cs) * mueff) * invSqrtY;
+			psNorm += ps[i] * ps[i];
+		}
+		psNorm = sqrt(psNorm);
+		
+		bool hsig = psNorm / sqrt(1.0 - pow(1.0 - cs, 2.0 * (gen + 1))) / chiN < 1.4 + 2.0 / (n + 1.0);
+		for(unsigned i = 0; i < n; i++) {
+			pc[i] = (1.0 - cc) * pc[i] + (hsig ? sqrt(cc * (2.0 - cc) * mueff) * yw[i] : 0.0);
+		}
+		
+		// Rank-one and rank-mu covariance updates
+		double hsigCorrection = hsig ? 0.0 : cc * (2.0 - cc);
+		for(unsigned i = 0; i < n; i++) {
+			for(unsigned j = 0; j < n; j++) {
+				double rankMu = 0.0;
+				for(unsigned k = 0; k < mu; k++) {
+					rankMu += recombination[k] * steps[order[k]][i] * steps[order[k]][j];
+				}
+				C[i][j] = (1.0 - c1 - cmu) * C[i][j] + c1 * (pc[i] * pc[j] + hsigCorrection * C[i][j]) + cmu * rankMu;
+			}
+		}
+		
+		sigma *= exp((cs / damps) * (psNorm / chiN - 1.0));
+		
+		Vector meanWeights;
+		for(unsigned i = 0; i < n; i++) {
+			meanWeights[i] = mean[i] * scale[i];
+		}
+		HeuristicWeights meanHeuristic = weightsFromVector(meanWeights);
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		fprintf(stderr, "Generation %u: best %.0f median %.0f, mean %d,%d,%d,%d, sigma %.3f, %.1f games/sec\n",
+			gen + 1, fitness[order[0]], fitness[order[lambda / 2]],
+			meanHeuristic.emptyTile, meanHeuristic.bigTileOnEdge, meanHeuristic.nearMerge, meanHeuristic.monotonic,
+			sigma, (gen + 1) * lambda * gameCount / seconds
+		);
+	}
+	
+	// Best single batch is optimistic, so report it alongside its score; rerun with -w to confirm
+	fprintf(stderr, "Best average %.0f\n", bestFitness);
+	printf("%d,%d,%d,%d\n", bestWeights.emptyTile, bestWeights.bigTileOnEdge, bestWeights.nearMerge, bestWeights.monotonic);
+	return 0;
+}